@@ -32,6 +32,9 @@ namespace pst {
         0      // KING
     };
 
+    // Game phase weight of each piece type, 24 for a full set of pieces
+    static constexpr std::array<int, 6> game_phase_inc = {0, 1, 1, 2, 4, 0};
+
     // Static piece values for endgame
     static constexpr std::array<int, 6> eg_value = {
         206,   // PAWN
@@ -222,4 +225,15 @@ namespace eval {
     
     constexpr std::array<int, 28> queen_mobility_mg = {-30, -12, -8, -9, 20, 23, 23, 35, 38, 53, 64, 65, 65, 66, 67, 67, 72, 72, 77, 79, 93, 108, 108, 108, 110, 114, 114, 116};
     constexpr std::array<int, 28> queen_mobility_eg = {-48, -30, -7, 19, 40, 55, 59, 75, 78, 96, 96, 100, 121, 127, 131, 133, 136, 141, 147, 150, 151, 168, 168, 171, 182, 182, 192, 219};
+
+    // Pawn structure, passed pawn bonus indexed by relative rank
+    constexpr std::array<int, 8> passed_pawn_mg = {0, 10, 17, 15, 62, 168, 276, 0};
+    constexpr std::array<int, 8> passed_pawn_eg = {0, 28, 33, 41, 72, 177, 260, 0};
+
+    constexpr int isolated_pawn_mg = 5;
+    constexpr int isolated_pawn_eg = 15;
+    constexpr int doubled_pawn_mg  = 11;
+    constexpr int doubled_pawn_eg  = 56;
+    constexpr int backward_pawn_mg = 9;
+    constexpr int backward_pawn_eg = 24;
 }  // namespace eval
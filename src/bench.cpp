@@ -1,36 +1,522 @@
 #include "bench.h"
+#include "evaluate.h"
+#include "nnue.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <thread>
 
 
-void bench::run(int depth) {
-    uint64_t nodes = 0;
+#if COUNT_ALLOCATIONS
+static std::atomic<uint64_t> allocations = 0;
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+uint64_t bench::get_allocations() { return allocations.load(std::memory_order_relaxed); }
+#else
+uint64_t bench::get_allocations() { return 0; }
+#endif
+
+
+/**
+ * Parses a whole token as an integer, without throwing on malformed or out of range input.
+ *
+ * @param token Text to parse
+ * @param value Parsed number, only meaningful on success
+ * @return True if the token is nothing but a number in the range of the type
+ */
+template<typename T>
+static bool parse_number(std::string_view token, T& value) {
+    const char* end = token.data() + token.size();
+    auto [ptr, ec]  = std::from_chars(token.data(), end, value);
+    return ec == std::errc() && ptr == end && !token.empty();
+}
+
+/**
+ * Reads the optional count following a bench mode, such as the number of runs.
+ *
+ * @param is Arguments of the command, rewound to the next token if it is not a count
+ * @param count Parsed count, unchanged if the next token is not a number
+ */
+static void read_count(std::istringstream& is, int& count) {
+    std::string token;
+    auto        start = is.tellg();
+
+    if (is >> token && parse_number(token, count))
+        return;
+
+    is.clear();
+    is.seekg(start);
+}
+
+void bench::Config::parse(std::istringstream& is) {
+    std::string token;
+    int         numbers = 0;
+    int64_t     number;
+
+    while (is >> token)
+    {
+        if (token == "depth" || token == "movetime" || token == "nodes")
+            limit_type = token;
+
+        else if (token == "reuse")
+            reuse = true;
+
+        else if (token == "default")
+            file.clear();
+
+        // limit, threads and hash size, in this order, anything else being a file name
+        else if (numbers < 3 && parse_number(token, number))
+        {
+            if (numbers == 0)
+                limit = std::max<int64_t>(1, number);
+            else if (numbers == 1)
+                threads = int(std::clamp<int64_t>(number, 1, MAX_THREADS));
+            else
+                hash_mib = uint64_t(std::clamp<int64_t>(number,
+                                                        TranspositionTable::MINHASH_MiB,
+                                                        TranspositionTable::MAXHASH_MiB));
+            numbers++;
+        }
+
+        else
+            file = token;
+    }
+}
+
+void bench::command(std::istringstream& is) {
+    std::string mode;
+    auto        start = is.tellg();
+    is >> mode;
+
+    Config config;
+    int    runs = 1;
+
+    if (mode == "micro")
+        micro();
+
+    else if (mode == "eval")
+    {
+        int iterations = 20000;
+        read_count(is, iterations);
+        eval_speed(std::max(1, iterations));
+    }
+
+    else if (mode == "ttstress")
+    {
+        int threads = std::max(4u, std::thread::hardware_concurrency());
+        read_count(is, threads);
+        tt_stress(std::clamp(threads, 1, MAX_THREADS));
+    }
+
+    else if (mode == "json" || mode == "csv")
+    {
+        read_count(is, runs);
+        config.parse(is);
+        report(mode == "json", std::max(1, runs), config);
+    }
+
+    else if (mode == "parallel")
+    {
+        int n = std::max(1u, std::thread::hardware_concurrency());
+        read_count(is, n);
+        config.parse(is);
+        parallel(std::clamp(n, 1, MAX_THREADS), config);
+    }
+
+    else if (mode == "compare")
+    {
+        std::string path;
+        is >> path;
+        runs = 3;
+        read_count(is, runs);
+        config.parse(is);
+        compare(path, std::max(2, runs), config);
+    }
+
+    else
+    {
+        // no mode, the arguments are the settings of a plain bench
+        is.clear();
+        is.seekg(start);
+        config.parse(is);
+        run(config);
+    }
+}
+
+std::vector<std::string> bench::load_positions(const std::string& file) {
+    if (file.empty())
+        return {benchfens.begin(), benchfens.end()};
+
+    std::vector<std::string> fens;
+    std::ifstream            input(file);
+    std::string              line;
+
+    if (!input)
+        std::cout << "info string cannot open " << file << std::endl;
+
+    while (std::getline(input, line))
+    {
+        std::istringstream fields(line);
+        std::string        field, fen;
+        int                count = 0;
+
+        // board, side, castling and en passant, then the move counters when present,
+        // EPD operations such as "bm e4;" following otherwise
+        while (count < 6 && fields >> field)
+        {
+            if (count >= 4 && !std::all_of(field.begin(), field.end(), ::isdigit))
+                break;
+            fen += (count++ ? " " : "") + field;
+        }
+
+        if (count < 4 || fen[0] == '#')
+            continue;
+
+        fens.push_back(count == 4 ? fen + " 0 1" : fen);
+    }
+
+    return fens;
+}
+
+bench::BenchResult bench::search_positions(const Config& config, bool verbose) {
+    BenchResult result;
 
     Limits limits;
-    limits.depth = depth;
-    limits.nodes = 0;
+    limits.depth = config.limit_type == "depth" ? int(std::min<int64_t>(config.limit, MAX_PLY))
+                                                : MAX_PLY;
+    limits.nodes = config.limit_type == "nodes" ? config.limit : 0;
     limits.time  = Time();
 
+    if (config.limit_type == "movetime")
+        limits.time.optimum = limits.time.maximum = config.limit;
+
+    std::vector<std::string> fens = load_positions(config.file);
+    std::unique_ptr<Engine>  engine;
+
     int i = 1;
 
     auto t0 = std::chrono::high_resolution_clock::now();
 
-    for (auto& fen : benchfens)
+    for (auto& fen : fens)
     {
-        std::cout << "Position: " << i++ << "/" << benchfens.size() << " " << fen << std::endl;
+        if (verbose)
+            std::cout << "Position: " << i++ << "/" << fens.size() << " " << fen << std::endl;
+
+        if (!engine || !config.reuse)
+        {
+            engine        = std::make_unique<Engine>();
+            engine->debug = false;
+            engine->set_threads(config.threads);
+            if (config.hash_mib != engine->tt->get_size_mib() || config.threads > 1)
+                engine->tt->resize(config.hash_mib, config.threads);
+        }
 
-        Engine engine;
-        engine.debug  = false;
-        engine.limits = limits;
-        engine.board.setFen(fen);
-        engine.get_bestmove(depth);
+        engine->limits      = limits;
+        engine->stop_search = false;
+        engine->board.setFen(fen);
 
-        nodes += engine.nodes;
+        auto     p0           = std::chrono::high_resolution_clock::now();
+        uint64_t alloc_before = get_allocations();
+        Move     bestmove     = engine->get_bestmove(limits.depth);
+        result.allocations += get_allocations() - alloc_before;
+        auto p1 = std::chrono::high_resolution_clock::now();
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(p1 - p0).count();
+
+        PositionResult position;
+        position.fen      = fen;
+        position.nodes    = engine->get_total_nodes();
+        position.time_ms  = ms;
+        position.depth    = engine->completed_depth;
+        position.bestmove = bestmove;
+        position.tt_hit_rate =
+          engine->tt_probes ? 100.0 * engine->tt_hits / engine->tt_probes : 0.0;
+
+        result.nodes += position.nodes;
+        result.stats.add(engine->get_search_stats());
+        result.positions.push_back(position);
     }
 
-    auto t1      = std::chrono::high_resolution_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
+    // the total time includes the allocation of the engines, as it always has
+    auto t1        = std::chrono::high_resolution_clock::now();
+    result.time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
+
+    return result;
+}
+
+void bench::run(const Config& config) {
+    BenchResult result = search_positions(config, true);
+
+    uint64_t nodes   = result.nodes;
+    auto     elapsed = result.time_ms;
 
     auto nps = signed((nodes / (elapsed + 1)) * 1000);
 
     std::cout << "\n\ninfo string " << elapsed / 1000.0 << " seconds" << std::endl;
     std::cout << nodes << " nodes " << nps << " nps" << std::endl;
-}
\ No newline at end of file
+    if constexpr (COUNT_ALLOCATIONS)
+        std::cout << result.allocations << " allocations "
+                  << double(result.allocations) / (nodes + 1) << " allocations per node"
+                  << std::endl;
+
+    if constexpr (SEARCH_STATS)
+        result.stats.print();
+}
+
+/**
+ * Escapes a string for use inside a JSON string literal.
+ *
+ * @param text Raw string
+ * @return String with quotes, backslashes and control characters escaped
+ */
+static std::string json_escape(const std::string& text) {
+    std::string escaped;
+
+    for (char ch : text)
+    {
+        if (ch == '"' || ch == '\\')
+            escaped += std::string("\\") + ch;
+        else if (static_cast<unsigned char>(ch) < 0x20)
+        {
+            char code[7];
+            std::snprintf(code, sizeof(code), "\\u%04x", ch);
+            escaped += code;
+        }
+        else
+            escaped += ch;
+    }
+
+    return escaped;
+}
+
+void bench::report(bool json, int runs, const Config& config) {
+    std::vector<BenchResult> results;
+    for (int r = 0; r < runs; r++)
+        results.push_back(search_positions(config, false));
+
+    if (!json)
+    {
+        std::cout << "run,fen,nodes,time_ms,depth,bestmove,tt_hit_rate\n";
+        for (int r = 0; r < runs; r++)
+            for (auto& p : results[r].positions)
+                std::cout << r + 1 << "," << p.fen << "," << p.nodes << "," << p.time_ms << ","
+                          << p.depth << "," << uci::moveToUci(p.bestmove) << ","
+                          << p.tt_hit_rate << "\n";
+        std::cout << std::flush;
+        return;
+    }
+
+    // the positions of the first run, node counts being the same in every run
+    std::cout << "{\n";
+    std::cout << "  \"engine\": \"CHIMP\",\n";
+    std::cout << "  \"limit\": " << config.limit << ",\n";
+    std::cout << "  \"limit_type\": \"" << json_escape(config.limit_type) << "\",\n";
+    std::cout << "  \"threads\": " << config.threads << ",\n";
+    std::cout << "  \"hash\": " << config.hash_mib << ",\n";
+    std::cout << "  \"positions_file\": \""
+              << json_escape(config.file.empty() ? "default" : config.file) << "\",\n";
+    std::cout << "  \"reuse\": " << (config.reuse ? "true" : "false") << ",\n";
+    std::cout << "  \"total_nodes\": " << results[0].nodes << ",\n";
+    std::cout << "  \"nps_runs\": [";
+    for (int r = 0; r < runs; r++)
+        std::cout << (r ? ", " : "") << results[r].nps();
+    std::cout << "],\n";
+    std::cout << "  \"positions\": [\n";
+
+    auto& positions = results[0].positions;
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        auto& p = positions[i];
+        std::cout << "    {\"fen\": \"" << json_escape(p.fen) << "\", \"nodes\": " << p.nodes
+                  << ", \"time_ms\": " << p.time_ms << ", \"depth\": " << p.depth
+                  << ", \"bestmove\": \"" << json_escape(uci::moveToUci(p.bestmove))
+                  << "\", \"tt_hit_rate\": " << p.tt_hit_rate << "}"
+                  << (i + 1 < positions.size() ? "," : "") << "\n";
+    }
+
+    std::cout << "  ]\n}" << std::endl;
+}
+
+/**
+ * Finds a key of a JSON report and returns the text following its colon.
+ *
+ * @param json Content of the report
+ * @param key Name of the key
+ * @return Text after the key, or an empty string if the key is missing
+ */
+static std::string json_value(const std::string& json, const std::string& key) {
+    size_t pos = json.find("\"" + key + "\"");
+    if (pos == std::string::npos)
+        return "";
+
+    pos = json.find(':', pos);
+    return pos == std::string::npos ? "" : json.substr(pos + 1);
+}
+
+/**
+ * Computes the mean and the variance of the mean of a sample.
+ *
+ * @param sample Measured values, at least two of them
+ * @return Mean of the sample, and variance of that mean
+ */
+static std::pair<double, double> mean_and_variance(const std::vector<double>& sample) {
+    double mean = 0.0, variance = 0.0;
+
+    for (double x : sample)
+        mean += x / sample.size();
+
+    for (double x : sample)
+        variance += (x - mean) * (x - mean) / (sample.size() - 1);
+
+    return {mean, variance / sample.size()};
+}
+
+void bench::compare(const std::string& baseline, int runs, const Config& config) {
+    std::ifstream file(baseline);
+    std::string   json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::vector<double> base;
+    std::istringstream  nps_runs(json_value(json, "nps_runs"));
+    char                separator;
+    double              nps;
+
+    nps_runs >> separator;  // opening bracket
+    while (nps_runs >> nps)
+    {
+        base.push_back(nps);
+        nps_runs >> separator;
+        if (separator == ']')
+            break;
+    }
+
+    if (base.size() < 2)
+    {
+        std::cout << "info string " << baseline
+                  << " holds less than 2 runs, save it with bench json <runs>" << std::endl;
+        return;
+    }
+
+    std::vector<double> current;
+    uint64_t            nodes = 0;
+    for (int r = 0; r < runs; r++)
+    {
+        BenchResult result = search_positions(config, false);
+        nodes              = result.nodes;
+        current.push_back(double(result.nps()));
+    }
+
+    auto [base_mean, base_var] = mean_and_variance(base);
+    auto [curr_mean, curr_var] = mean_and_variance(current);
+
+    // WELCH'S T-TEST
+    // the runs of each side may have different variances and counts
+    double se   = std::sqrt(base_var + curr_var);
+    double df   = se > 0 ? std::pow(se, 4)
+                           / (base_var * base_var / (base.size() - 1)
+                              + curr_var * curr_var / (current.size() - 1))
+                         : 1e9;
+    double diff = curr_mean - base_mean;
+
+    // two-sided 95% quantiles of Student's t-distribution, for 1 to 10 degrees of freedom
+    static constexpr double t95[] = {12.71, 4.30, 3.18, 2.78, 2.57, 2.45, 2.36, 2.31, 2.26, 2.23};
+    double t = df < 10.5 ? t95[std::max(0, int(std::lround(df)) - 1)] : df < 30 ? 2.10 : 1.96;
+
+    // the value runs up to the next separator, a malformed one skips the check
+    std::string base_field = json_value(json, "total_nodes");
+    std::string base_token = base_field.substr(0, base_field.find_first_of(",}"));
+    base_token.erase(0, base_token.find_first_not_of(" \t\r\n"));
+    base_token.erase(base_token.find_last_not_of(" \t\r\n") + 1);
+
+    uint64_t base_nodes;
+    if (parse_number(base_token, base_nodes) && base_nodes != nodes)
+        std::cout << "info string node count differs from the baseline (" << nodes << " vs "
+                  << base_nodes << "), the search has changed" << std::endl;
+
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << "baseline " << base_mean << " nps +- " << t * std::sqrt(base_var) << " ("
+              << base.size() << " runs)" << std::endl;
+    std::cout << "current  " << curr_mean << " nps +- " << t * std::sqrt(curr_var) << " ("
+              << current.size() << " runs)" << std::endl;
+    std::cout << std::showpos << std::setprecision(2);
+    std::cout << "nps delta " << 100.0 * diff / base_mean << "% +- " << std::noshowpos
+              << 100.0 * t * se / base_mean << "% (95% confidence)" << std::endl;
+}
+
+void bench::parallel(int n, const Config& config) {
+    std::cout << "info string single benchmark" << std::endl;
+    BenchResult single = search_positions(config, false);
+    std::cout << single.nodes << " nodes " << single.nps() << " nps" << std::endl;
+
+    std::cout << "info string " << n << " concurrent benchmarks" << std::endl;
+
+    std::vector<BenchResult> results(n);
+    std::vector<std::thread> workers;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    for (int t = 0; t < n; t++)
+        workers.emplace_back([&, t]() { results[t] = search_positions(config, false); });
+
+    for (auto& worker : workers)
+        worker.join();
+
+    auto t1      = std::chrono::high_resolution_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
+
+    uint64_t nodes = 0;
+    for (int t = 0; t < n; t++)
+    {
+        std::cout << "thread " << t + 1 << ": " << results[t].nodes << " nodes "
+                  << results[t].nps() << " nps" << std::endl;
+        nodes += results[t].nodes;
+    }
+
+    uint64_t aggregate = nodes * 1000 / (elapsed + 1);
+    double   scaling   = double(aggregate) / std::max<uint64_t>(single.nps(), 1);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "aggregate: " << nodes << " nodes " << aggregate << " nps, scaling " << scaling
+              << "x on " << n << " threads (" << 100.0 * scaling / n << "% efficiency)"
+              << std::endl;
+}
+
+void bench::eval_speed(int iterations) {
+    std::vector<Position> positions(benchfens.begin(), benchfens.end());
+    EvalTables            tables;
+    int64_t               checksum = 0;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < iterations; i++)
+        for (auto& pos : positions)
+            checksum += evaluate(pos, tables);
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+
+    uint64_t evals   = uint64_t(iterations) * positions.size();
+    std::string mode = nnue::is_loaded() ? std::string("nnue ") + nnue::simd_name() : "classical";
+
+    std::cout << evals * 1000000000 / (ns + 1) << " evals per second (" << mode << ", checksum "
+              << checksum << ")" << std::endl;
+}
@@ -3,17 +3,171 @@
 #include "types.h"
 #include "engine.h"
 #include "perft.h"
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Heap allocations are counted with make ALLOCS=1, the engine allocates normally otherwise
+#ifndef COUNT_ALLOCATIONS
+    #define COUNT_ALLOCATIONS 0
+#endif
 
 
 namespace bench {
 
+/**
+ * Settings of a benchmark, parsed from
+ * [limit] [threads] [hashMB] [file.epd|default] [depth|movetime|nodes] [reuse]
+ */
+struct Config {
+    int64_t     limit      = 12;       // per position, in plies, milliseconds or nodes
+    std::string limit_type = "depth";  // depth, movetime or nodes
+    int         threads    = 1;
+    uint64_t    hash_mib   = TranspositionTable::DEFAULT_HASH_MiB;
+    std::string file;                  // FEN or EPD file, the bench positions if empty
+    bool        reuse = false;         // one engine for every position, keeping its TT warm
+
+    /**
+     * Reads the settings given after the bench mode, keeping defaults for missing ones.
+     *
+     * @param is Input stream containing the settings
+     */
+    void parse(std::istringstream& is);
+};
+
+/**
+ * Search result of one benchmark position.
+ */
+struct PositionResult {
+    std::string fen;
+    uint64_t    nodes       = 0;
+    int64_t     time_ms     = 0;
+    int         depth       = 0;  // last completed iteration
+    Move        bestmove    = Move::NO_MOVE;
+    double      tt_hit_rate = 0.0;
+};
+
+/**
+ * Results of one pass over the benchmark positions.
+ */
+struct BenchResult {
+    std::vector<PositionResult> positions;
+    uint64_t                    nodes       = 0;
+    int64_t                     time_ms     = 0;
+    uint64_t                    allocations = 0;  // made while searching
+    [[no_unique_address]] SearchStats stats;
+
+    uint64_t nps() const { return nodes * 1000 / (time_ms + 1); }
+};
+
+/**
+ * Parses the arguments of the bench command and runs the requested benchmark:
+ * bench, bench micro, bench ttstress [threads], bench json [runs], bench csv [runs],
+ * bench parallel [n] or
+ * bench compare <baseline.json> [runs], any of them but micro followed by a Config
+ *
+ * @param is Input stream containing the arguments following "bench"
+ */
+void command(std::istringstream& is);
+
+/**
+ * Reads the positions of a benchmark.
+ * Lines of EPD files lack the move counters, which are then set to "0 1".
+ *
+ * @param file FEN or EPD file, one position per line, the 50 bench positions if empty
+ * @return FEN strings of the positions
+ */
+std::vector<std::string> load_positions(const std::string& file);
+
+/**
+ * Searches every benchmark position, with a fresh engine each unless config.reuse is set.
+ *
+ * @param config Limits, threads, hash size and positions of the benchmark
+ * @param verbose Prints every position before searching it
+ * @return Per-position and total results
+ */
+BenchResult search_positions(const Config& config, bool verbose);
+
 /**
  * Runs a standardized benchmark on a set of 50 test positions.
  * Used for performance testing and OpenBench compatibility.
  *
- * @param depth The search depth to use for benchmarking
+ * @param config Settings of the benchmark, depth 12 on the bench positions by default
+ */
+void run(const Config& config = Config());
+
+/**
+ * Measures the throughput of the static evaluation on the benchmark positions,
+ * with the NNUE network if one is loaded. Run by bench eval only, so that the
+ * output of the plain bench stays the one parsed by OpenBench.
+ *
+ * @param iterations Number of times every position is evaluated
+ */
+void eval_speed(int iterations = 20000);
+
+/**
+ * Prints the results of the benchmark as JSON or CSV, one record per position.
+ * The JSON report also holds the total NPS of every run, so that it can serve
+ * as the baseline of a later comparison.
+ *
+ * @param json True for JSON, false for CSV
+ * @param runs Number of times the benchmark is repeated
+ * @param config Settings of the benchmark
+ */
+void report(bool json, int runs = 1, const Config& config = Config());
+
+/**
+ * Repeats the benchmark and compares its NPS with a baseline saved by bench json.
+ * The difference of the means is printed with its 95% confidence interval.
+ *
+ * @param baseline Path of the JSON report to compare with
+ * @param runs Number of times the benchmark is repeated
+ * @param config Settings of the benchmark, which should match those of the baseline
+ */
+void compare(const std::string& baseline, int runs = 3, const Config& config = Config());
+
+/**
+ * Measures the throughput of independent searches running concurrently.
+ * The benchmark first runs alone, then on n threads at once, each thread with its own
+ * engines and transposition tables, and the aggregate NPS is compared with the single
+ * run to expose the memory bandwidth and false sharing limits of the machine.
+ *
+ * @param n Number of concurrent benchmarks
+ * @param config Settings of each benchmark
+ */
+void parallel(int n, const Config& config = Config());
+
+/**
+ * Times the building blocks of the search one by one on the benchmark positions:
+ * move generation, evaluation, SEE, transposition table probes and stores,
+ * make/unmake and move picking. Every operation gets warm-up runs before the
+ * timed ones, and the median and minimum cost per call are printed in nanoseconds.
+ *
+ * @param runs Number of timed runs per operation
+ */
+void micro(int runs = 9);
+
+/**
+ * Checks that concurrent stores never leave a torn transposition table entry.
+ * Threads store and probe a small shared table, every field of an entry being
+ * derived from its 16-bit key, so that a hit whose fields do not match its key can
+ * only come from a mix of two writes.
+ *
+ * @param threads Number of threads storing and probing concurrently
+ * @param iterations Number of stores and probes per thread
+ * @return True if no torn entry was found
+ */
+bool tt_stress(int threads, int iterations = 2000000);
+
+/**
+ * Returns the number of heap allocations made by the program so far.
+ * Counted by the global operator new replaced in bench.cpp, so that bench
+ * can check that searching never allocates. The replacement is only compiled
+ * into builds made with ALLOCS=1, and this returns 0 in the others.
+ *
+ * @return Total number of calls to operator new
  */
-void run(int depth = 12);
+uint64_t get_allocations();
 
 // fens from Stormphrax, ultimately from bitgenie
 static const std::array<std::string, 50> benchfens{
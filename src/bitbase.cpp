@@ -0,0 +1,158 @@
+#include "bitbase.h"
+#include <bitset>
+#include <vector>
+
+namespace bitbase {
+
+// Positions are stored with white holding the pawn, on files A to D
+static std::bitset<MAX_INDEX> kpk_bitbase;
+
+enum Result : uint8_t {
+    INVALID = 0,
+    UNKNOWN = 1,
+    DRAW    = 2,
+    WIN     = 4
+};
+
+/**
+ * @brief Computes the index of a position in the bitbase
+ * @param white_to_move Side to move
+ * @param bk Square of the black king
+ * @param wk Square of the white king
+ * @param psq Square of the white pawn, on files A to D and ranks 2 to 7
+ * @return Index of the position
+ */
+static int index(bool white_to_move, int bk, int wk, int psq) {
+    return wk | (bk << 6) | (!white_to_move << 12) | ((psq & 7) << 13) | ((6 - psq / 8) << 15);
+}
+
+// Squares attacked by a king, filled by init()
+static uint64_t king_attacks[64];
+
+static bool adjacent(int sq1, int sq2) { return king_attacks[sq1] >> sq2 & 1; }
+
+static uint64_t pawn_attacks(int psq) {
+    const uint64_t bb = 1ull << psq;
+    return ((bb & ~0x0101010101010101ull) << 7) | ((bb & ~0x8080808080808080ull) << 9);
+}
+
+/**
+ * @struct KPKPosition
+ * @brief Position of the bitbase being classified
+ */
+struct KPKPosition {
+    bool   white_to_move;
+    int    wk, bk, psq;
+    Result result;
+
+    explicit KPKPosition(int idx) {
+        wk            = idx & 0x3F;
+        bk            = (idx >> 6) & 0x3F;
+        white_to_move = !((idx >> 12) & 1);
+        psq           = ((idx >> 13) & 3) + 8 * (6 - ((idx >> 15) & 7));
+
+        const int stop = psq + 8;
+
+        // kings touching, pieces on the same square, or the side not to move in check
+        if (adjacent(wk, bk) || wk == psq || bk == psq || (white_to_move && (pawn_attacks(psq) >> bk & 1)))
+            result = INVALID;
+
+        // the pawn promotes and cannot be captured
+        else if (white_to_move && psq / 8 == 6 && wk != stop && bk != stop
+                 && (!adjacent(bk, stop) || adjacent(wk, stop)))
+            result = WIN;
+
+        // stalemate, or the black king captures the undefended pawn
+        else if (!white_to_move && (is_stalemate() || (adjacent(bk, psq) && !adjacent(wk, psq))))
+            result = DRAW;
+
+        else
+            result = UNKNOWN;
+    }
+
+    bool is_stalemate() const {
+        return !(king_attacks[bk] & ~(king_attacks[wk] | pawn_attacks(psq)));
+    }
+
+    /**
+     * @brief Classifies the position from the results of its children
+     * @param db Current results of every position
+     * @return Result of the position, UNKNOWN while its children are not decided
+     */
+    Result classify(const std::vector<KPKPosition>& db) const {
+        // white wins as soon as one child wins, black draws as soon as one child draws
+        const Result good = white_to_move ? WIN : DRAW;
+        const Result bad  = white_to_move ? DRAW : WIN;
+
+        int      r     = INVALID;
+        uint64_t moves = king_attacks[white_to_move ? wk : bk];
+
+        while (moves)
+        {
+            const int sq = __builtin_ctzll(moves);
+            moves &= moves - 1;
+
+            r |= white_to_move ? db[index(false, bk, sq, psq)].result
+                               : db[index(true, sq, wk, psq)].result;
+        }
+
+        if (white_to_move && psq / 8 < 6)
+        {
+            r |= db[index(false, bk, wk, psq + 8)].result;
+
+            // double push, the stop square must be empty
+            if (psq / 8 == 1 && psq + 8 != wk && psq + 8 != bk)
+                r |= db[index(false, bk, wk, psq + 16)].result;
+        }
+
+        return r & good ? good : r & UNKNOWN ? UNKNOWN : bad;
+    }
+};
+
+void init() {
+    for (int sq = 0; sq < 64; sq++)
+    {
+        king_attacks[sq] = 0;
+        for (int to = 0; to < 64; to++)
+            if (to != sq && Square::distance(Square(sq), Square(to)) <= 1)
+                king_attacks[sq] |= 1ull << to;
+    }
+
+    std::vector<KPKPosition> db;
+    db.reserve(MAX_INDEX);
+
+    for (int idx = 0; idx < MAX_INDEX; idx++)
+        db.emplace_back(idx);
+
+    // iterate until no position changes, positions left unknown are draws
+    bool repeat = true;
+    while (repeat)
+    {
+        repeat = false;
+        for (auto& pos : db)
+            if (pos.result == UNKNOWN && (pos.result = pos.classify(db)) != UNKNOWN)
+                repeat = true;
+    }
+
+    for (int idx = 0; idx < MAX_INDEX; idx++)
+        kpk_bitbase[idx] = db[idx].result == WIN;
+}
+
+bool probe_kpk(Square strong_king, Square pawn, Square weak_king, bool strong_to_move,
+               Color strong) {
+    int wk  = strong_king.relative_square(strong).index();
+    int bk  = weak_king.relative_square(strong).index();
+    int psq = pawn.relative_square(strong).index();
+
+    // mirror pawns of files E to H
+    if (psq % 8 >= 4)
+    {
+        wk ^= 7;
+        bk ^= 7;
+        psq ^= 7;
+    }
+
+    return kpk_bitbase[index(strong_to_move, bk, wk, psq)];
+}
+
+}  // namespace bitbase
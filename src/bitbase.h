@@ -0,0 +1,35 @@
+#pragma once
+#include "chess.hpp"
+
+using namespace chess;
+
+/**
+ * King and pawn versus king bitbase.
+ *
+ * One bit per position tells whether the side with the pawn wins, for every
+ * placement of the kings, every pawn square of files A to D (the other files are
+ * mirrored) and both sides to move: 2 x 24 x 64 x 64 bits, i.e. 24 KiB.
+ * It is generated at startup by retrograde analysis, in a few milliseconds.
+ */
+namespace bitbase {
+
+constexpr int MAX_INDEX = 2 * 24 * 64 * 64;
+
+/**
+ * @brief Generates the bitbase, must be called once before any probe
+ */
+void init();
+
+/**
+ * @brief Looks up a king and pawn versus king position
+ * @param strong_king Square of the king of the side with the pawn
+ * @param pawn Square of the pawn
+ * @param weak_king Square of the lone king
+ * @param strong_to_move True if the side with the pawn is to move
+ * @param strong Color of the side with the pawn
+ * @return True if the side with the pawn wins, false if the position is a draw
+ */
+bool probe_kpk(Square strong_king, Square pawn, Square weak_king, bool strong_to_move,
+               Color strong);
+
+}  // namespace bitbase
@@ -0,0 +1,138 @@
+#include "book.h"
+#include <fstream>
+
+#if defined(__linux__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+/**
+ * @brief Reads a big-endian integer
+ * @param p Pointer to the first byte
+ * @param bytes Size of the integer in bytes
+ * @return Value of the integer
+ */
+static uint64_t read_be(const uint8_t* p, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++)
+        value = (value << 8) | p[i];
+    return value;
+}
+
+PolyglotBook::~PolyglotBook() { close(); }
+
+bool PolyglotBook::open(const std::string& path) {
+    close();
+
+#if defined(__linux__)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    const off_t file_size = lseek(fd, 0, SEEK_END);
+    void*       base      = file_size >= off_t(ENTRY_SIZE)
+                            ? mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0)
+                            : MAP_FAILED;
+    ::close(fd);
+
+    if (base == MAP_FAILED)
+        return false;
+
+    entries = static_cast<const uint8_t*>(base);
+    size    = file_size;
+#else
+    std::ifstream file(path, std::ios::binary);
+    buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    if (buffer.size() < ENTRY_SIZE)
+        return false;
+
+    entries = buffer.data();
+    size    = buffer.size();
+#endif
+
+    count = size / ENTRY_SIZE;
+
+    if (size % ENTRY_SIZE)
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void PolyglotBook::close() {
+#if defined(__linux__)
+    if (entries)
+        munmap(const_cast<uint8_t*>(entries), size);
+#else
+    buffer.clear();
+#endif
+
+    entries = nullptr;
+    count   = 0;
+    size    = 0;
+}
+
+Move PolyglotBook::probe(const Board& board, bool best) {
+    if (!entries)
+        return Move::NO_MOVE;
+
+    const uint64_t key = board.hash();
+
+    // BINARY SEARCH
+    // find the first entry of the position
+    size_t low = 0, high = count;
+    while (low < high)
+    {
+        size_t mid = (low + high) / 2;
+        if (read_be(entries + mid * ENTRY_SIZE, 8) < key)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    Movelist legal;
+    movegen::legalmoves(legal, board);
+
+    Move     chosen       = Move::NO_MOVE;
+    uint64_t total_weight = 0;
+    uint16_t best_weight  = 0;
+
+    for (size_t i = low; i < count && read_be(entries + i * ENTRY_SIZE, 8) == key; i++)
+    {
+        const uint16_t pg_move = read_be(entries + i * ENTRY_SIZE + 8, 2);
+        const uint16_t weight  = read_be(entries + i * ENTRY_SIZE + 10, 2);
+
+        // to square in bits 0-5, from square in bits 6-11, promotion piece in bits 12-14,
+        // castling is encoded as the king capturing its rook, like the chess library does
+        const int to    = pg_move & 0x3F;
+        const int from  = (pg_move >> 6) & 0x3F;
+        const int promo = (pg_move >> 12) & 0x7;
+
+        Move move = Move::NO_MOVE;
+        for (const Move& candidate : legal)
+            if (candidate.from().index() == from && candidate.to().index() == to
+                && (candidate.typeOf() == Move::PROMOTION
+                      ? static_cast<int>(candidate.promotionType()) == promo
+                      : promo == 0))
+                move = candidate;
+
+        if (move == Move::NO_MOVE || weight == 0)
+            continue;
+
+        // SELECTION
+        // best: highest weight, otherwise weighted reservoir sampling over the entries
+        total_weight += weight;
+
+        if (best ? weight > best_weight : rng() % total_weight < weight)
+        {
+            chosen      = move;
+            best_weight = weight;
+        }
+    }
+
+    return chosen;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "chess.hpp"
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace chess;
+
+/**
+ * @class PolyglotBook
+ * @brief Opening book in the Polyglot .bin format
+ * 
+ * The file is a sequence of 16-byte big-endian entries sorted by position key:
+ * key (64 bits), move (16 bits), weight (16 bits) and learn data (32 bits).
+ * It is memory-mapped and binary searched, Board::hash() computing the same keys.
+ */
+class PolyglotBook {
+   public:
+    PolyglotBook() = default;
+
+    /**
+     * @brief Closes the book file
+     */
+    ~PolyglotBook();
+
+    PolyglotBook(const PolyglotBook&)            = delete;
+    PolyglotBook& operator=(const PolyglotBook&) = delete;
+
+    /**
+     * @brief Opens a book file, closing the previous one
+     * @param path Path of the .bin file
+     * @return True if the file exists and holds whole entries
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Closes the book file, if any
+     */
+    void close();
+
+    /**
+     * @brief Checks whether a book is open
+     * @return True if a book file is mapped
+     */
+    bool is_open() const { return entries != nullptr; }
+
+    /**
+     * @brief Picks a book move for a position
+     * @param board Current board position
+     * @param best True to pick the highest weighted move, false to pick at random
+     * proportionally to the weights
+     * @return Legal book move, or NO_MOVE if the position is not in the book
+     */
+    Move probe(const Board& board, bool best);
+
+   private:
+    static constexpr size_t ENTRY_SIZE = 16;
+
+    const uint8_t* entries = nullptr;
+    size_t         count   = 0;
+    size_t         size    = 0;
+
+#if !defined(__linux__)
+    std::vector<uint8_t> buffer;  // file content, where it cannot be mapped
+#endif
+
+    std::mt19937_64 rng{std::random_device{}()};
+};
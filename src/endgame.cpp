@@ -0,0 +1,122 @@
+#include "endgame.h"
+#include "arrays.h"
+#include "bitbase.h"
+#include "types.h"
+#include <algorithm>
+
+static constexpr uint64_t LIGHT_SQUARES_BB = 0x55AA55AA55AA55AAull;
+
+static constexpr int PAWN_EG   = pst::eg_value[static_cast<int>(PieceType::PAWN)];
+static constexpr int KNIGHT_EG = pst::eg_value[static_cast<int>(PieceType::KNIGHT)];
+static constexpr int BISHOP_EG = pst::eg_value[static_cast<int>(PieceType::BISHOP)];
+
+/**
+ * @brief Bonus for a king far away from the centre, 0 in the centre and 120 in a corner
+ * @param sq Square of the king
+ * @return Bonus for the side trying to mate that king
+ */
+static int push_to_edge(Square sq) {
+    int file = sq.file();
+    int rank = sq.rank();
+
+    return 20 * (std::max(3 - file, file - 4) + std::max(3 - rank, rank - 4));
+}
+
+/**
+ * @brief Bonus for two pieces close to each other, 0 at the maximum distance
+ * @param sq1 Square of the first piece
+ * @param sq2 Square of the second piece
+ * @return Bonus for bringing them closer
+ */
+static int push_close(Square sq1, Square sq2) { return 20 * (7 - Square::distance(sq1, sq2)); }
+
+/**
+ * @brief Converts a score from the strong side's perspective to the side to move's one
+ * @param pos Current board position
+ * @param strong Side the score is relative to
+ * @param score Score from the strong side's perspective
+ * @return Score from the side to move's perspective
+ */
+static int to_side_to_move(const Position& pos, Color strong, int score) {
+    return pos.sideToMove() == strong ? score : -score;
+}
+
+int evaluate_kxk(const Position& pos, Color strong) {
+    const Color weak = ~strong;
+
+    // a lone king out of check without legal moves is stalemated, when in check it is
+    // mated and keeps the winning score below
+    if (pos.sideToMove() == weak && !pos.inCheck())
+    {
+        Movelist moves;
+        movegen::legalmoves(moves, pos);
+        if (moves.empty())
+            return 0;
+    }
+
+    const Square strong_king = pos.kingSq(strong);
+    const Square weak_king   = pos.kingSq(weak);
+
+    int score = push_to_edge(weak_king) + push_close(strong_king, weak_king);
+
+    for (int pt = 0; pt < 5; pt++)
+        score += pos.pieces(PieceType(static_cast<PieceType::underlying>(pt)), strong).count()
+               * pst::eg_value[pt];
+
+    // queens, rooks, bishops of both colours, bishop and knight, and pawns that may
+    // promote force mate, lone knights or same coloured bishops cannot
+    const Bitboard bishops     = pos.pieces(PieceType::BISHOP, strong);
+    const bool     bishop_pair = (bishops & LIGHT_SQUARES_BB) && (bishops & ~LIGHT_SQUARES_BB);
+    const bool     mating_material =
+      pos.pieces(PieceType::QUEEN, strong) || pos.pieces(PieceType::ROOK, strong) || bishop_pair
+      || (bishops && pos.pieces(PieceType::KNIGHT, strong)) || pos.pieces(PieceType::PAWN, strong);
+
+    if (!mating_material)
+        return 0;
+
+    score += VALUE_KNOWN_WIN;
+
+    return to_side_to_move(pos, strong, score);
+}
+
+int evaluate_kbnk(const Position& pos, Color strong) {
+    const Color  weak        = ~strong;
+    const Square strong_king = pos.kingSq(strong);
+    const Square weak_king   = pos.kingSq(weak);
+    const Square bishop      = pos.pieces(PieceType::BISHOP, strong).lsb();
+
+    // the corners a1/h8 are dark, a8/h1 are light
+    const Square corner1 = bishop.is_light() ? Square::SQ_A8 : Square::SQ_A1;
+    const Square corner2 = bishop.is_light() ? Square::SQ_H1 : Square::SQ_H8;
+    const int    corner_distance =
+      std::min(Square::distance(weak_king, corner1), Square::distance(weak_king, corner2));
+
+    int score = VALUE_KNOWN_WIN + BISHOP_EG + KNIGHT_EG + push_close(strong_king, weak_king)
+              + 60 * (7 - corner_distance);
+
+    return to_side_to_move(pos, strong, score);
+}
+
+int evaluate_kpk(const Position& pos, Color strong) {
+    const Square pawn = pos.pieces(PieceType::PAWN, strong).lsb();
+
+    if (!bitbase::probe_kpk(pos.kingSq(strong), pawn, pos.kingSq(~strong),
+                            pos.sideToMove() == strong, strong))
+        return 0;
+
+    // the further advanced the pawn, the closer the promotion
+    int score = VALUE_KNOWN_WIN + PAWN_EG + 10 * pawn.relative_square(strong).rank();
+
+    return to_side_to_move(pos, strong, score);
+}
+
+int scale_opposite_bishops(const Position& pos) {
+    const Square white_bishop = pos.pieces(PieceType::BISHOP, Color::WHITE).lsb();
+    const Square black_bishop = pos.pieces(PieceType::BISHOP, Color::BLACK).lsb();
+
+    if (white_bishop.is_light() == black_bishop.is_light())
+        return SCALE_NORMAL;
+
+    // even a couple of extra pawns rarely win with bishops of opposite colours
+    return SCALE_NORMAL / 2;
+}
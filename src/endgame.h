@@ -0,0 +1,61 @@
+#pragma once
+#include "chess.hpp"
+#include "position.h"
+
+using namespace chess;
+
+/**
+ * @brief Specialised evaluation function of an endgame
+ * 
+ * Takes the position and the side holding the extra material, and returns the
+ * evaluation from the side to move's perspective.
+ */
+using EndgameFn = int (*)(const Position& pos, Color strong);
+
+/**
+ * @brief Scale factor of the endgame score, out of SCALE_NORMAL
+ */
+constexpr int SCALE_NORMAL = 64;
+constexpr int SCALE_DRAW   = 0;
+
+/**
+ * @brief Evaluates a lone king against at least a rook's worth of material
+ * 
+ * Drives the weak king to the edge and brings the strong king closer. Material
+ * that cannot force mate, like two knights, is evaluated as a draw.
+ * 
+ * @param pos Current board position
+ * @param strong Side with the mating material
+ * @return Evaluation from the side to move's perspective
+ */
+int evaluate_kxk(const Position& pos, Color strong);
+
+/**
+ * @brief Evaluates king, bishop and knight against a lone king
+ * 
+ * Drives the weak king to a corner of the bishop's colour, the only ones where
+ * mate can be forced.
+ * 
+ * @param pos Current board position
+ * @param strong Side with the bishop and knight
+ * @return Evaluation from the side to move's perspective
+ */
+int evaluate_kbnk(const Position& pos, Color strong);
+
+/**
+ * @brief Evaluates king and pawn against a lone king, exactly, with the KPK bitbase
+ * @param pos Current board position
+ * @param strong Side with the pawn
+ * @return Evaluation from the side to move's perspective
+ */
+int evaluate_kpk(const Position& pos, Color strong);
+
+/**
+ * @brief Computes the scale factor of opposite coloured bishop endings
+ * 
+ * Only called when each side has a single bishop and no other piece.
+ * 
+ * @param pos Current board position
+ * @return Scale factor, SCALE_NORMAL when the bishops share a colour
+ */
+int scale_opposite_bishops(const Position& pos);
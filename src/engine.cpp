@@ -9,6 +9,15 @@
 #include <cmath>
 
 
+Engine::Engine() :
+    tt(std::make_shared<TranspositionTable>()) {}
+
+Engine::Engine(std::shared_ptr<TranspositionTable> shared_tt, int id) :
+    tt(std::move(shared_tt)),
+    debug(false),
+    thread_id(id) {}
+
+
 void Engine::update_quiet_heuristics(Move move, int ply, int depth) {
     // KILLER MOVE UPDATE
     if (move != killer_moves[ply][0])
@@ -36,11 +45,11 @@ int Engine::get_reduction(
 }
 
 bool Engine::time_is_up() {
-    if (stop_search)
+    if (stop_search.load(std::memory_order_relaxed))
         return true;
 
     // handle go nodes <x>
-    if (limits.nodes > 0 && nodes >= limits.nodes)
+    if (limits.nodes > 0 && get_total_nodes() >= limits.nodes)
     {
         stop_search = true;
         return true;
@@ -48,13 +57,13 @@ bool Engine::time_is_up() {
 
     // Checking time every node is costly.
     // Instead, this bitmask trick is used to check only every 2048 nodes
-    if ((nodes & 2047) != 2047)
+    if ((nodes.load(std::memory_order_relaxed) & 2047) != 2047)
         return false;
 
     int64_t elapsed = get_elapsedtime();
 
-    // to handle bench properly
-    if (limits.time.maximum != 0)
+    // to handle bench and go infinite properly
+    if (limits.time.maximum != 0 && !limits.isInfinite)
     {
         // Hard limit
         if (elapsed >= limits.time.maximum)
@@ -106,18 +115,89 @@ void Engine::print_search_info(int depth, int score, uint64_t nodes, int64_t tim
     std::cout << " nodes " << nodes;
     std::cout << " time " << time_ms;
     std::cout << " nps " << (time_ms > 0 ? (nodes * 1000) / time_ms : 0);
+    std::cout << " hashfull " << tt->hashfull();
     std::cout << " pv " << get_pv_string();
     std::cout << std::endl;
 }
 
 void Engine::reset() {
-    board       = Board::fromFen(constants::STARTPOS);
+    board.setFen(constants::STARTPOS);
     nodes       = 0;
     stop_search = false;
-    tt.clear();
+    tt->new_search();
     init_tables();
 }
 
+void Engine::set_threads(int num_threads) {
+    helpers.clear();
+
+    for (int id = 1; id < num_threads; id++)
+        helpers.push_back(std::make_unique<Engine>(tt, id));
+}
+
+void Engine::start_helpers(int depth) {
+    for (auto& helper : helpers)
+    {
+        // Helpers are only stopped by the main thread, so they search without limits
+        helper->board       = board;
+        helper->limits      = Limits();
+        helper->nodes       = 0;
+        helper->stop_search = false;
+        helper->starttime   = starttime;
+
+        Engine* engine = helper.get();
+        helper_threads.emplace_back([engine, depth]() { engine->iterative_deepening(depth); });
+    }
+}
+
+void Engine::stop_helpers() {
+    for (auto& helper : helpers)
+        helper->stop_search = true;
+
+    for (auto& thread : helper_threads)
+        thread.join();
+
+    helper_threads.clear();
+}
+
+bool Engine::skip_depth(int depth) const {
+    // Lazy SMP skip pattern, from Stockfish 9.
+    // Helper i skips depths in blocks of skip_size[i], shifted by skip_phase[i].
+    static constexpr int skip_size[]  = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+    static constexpr int skip_phase[] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+    if (thread_id == 0)
+        return false;
+
+    int i = (thread_id - 1) % 20;
+    return ((depth + skip_phase[i]) / skip_size[i]) % 2;
+}
+
+uint64_t Engine::get_total_nodes() const {
+    uint64_t total = nodes.load(std::memory_order_relaxed);
+
+    for (auto& helper : helpers)
+        total += helper->nodes.load(std::memory_order_relaxed);
+
+    return total;
+}
+
+SearchStats Engine::get_search_stats() const {
+    SearchStats total = stats;
+
+    for (auto& helper : helpers)
+        total.add(helper->stats);
+
+    return total;
+}
+
+void Engine::clear_eval_caches() {
+    eval_cache.clear();
+
+    for (auto& helper : helpers)
+        helper->eval_cache.clear();
+}
+
 void Engine::init_tables() {
     // Initialize principal variation tables
     std::memset(pv_length, 0, sizeof(pv_length));
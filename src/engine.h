@@ -1,10 +1,17 @@
 #pragma once
 #include "chess.hpp"
 #include "types.h"
+#include "evaluate.h"
 #include "hash.h"
+#include "position.h"
+#include "stats.h"
+#include <atomic>
 #include <chrono>
 #include <cstring>
 #include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
 
 using namespace chess;
 
@@ -27,9 +34,25 @@ enum NodeType {
  */
 class Engine {
    public:
+    /**
+     * @brief Constructs a main search thread owning its transposition table
+     */
+    Engine();
+
+    /**
+     * @brief Constructs a Lazy SMP helper sharing the transposition table of the main thread
+     * @param shared_tt Transposition table of the main thread
+     * @param id Index of the helper thread, starting at 1
+     */
+    Engine(std::shared_ptr<TranspositionTable> shared_tt, int id);
+
     // Search functions
     /**
      * @brief Calculates the best move for the current position
+     *
+     * The caller clears stop_search before starting the search, so that a stop
+     * request arriving at any time is never lost.
+     *
      * @param depth Maximum search depth (defaults to MAX_PLY)
      * @return Best move found within the given constraints
      */
@@ -100,6 +123,71 @@ class Engine {
      */
     int get_reduction(int depth, int movecount, bool improving, bool is_pv_node, bool is_capture);
 
+    // Lazy SMP functions
+    /**
+     * @brief Sets the number of search threads, main thread included
+     * @param num_threads Total number of threads searching the root position
+     */
+    void set_threads(int num_threads);
+
+    /**
+     * @brief Starts every helper thread on the current position
+     * @param depth Maximum search depth of the helpers
+     */
+    void start_helpers(int depth);
+
+    /**
+     * @brief Signals every helper thread to stop and waits for them to finish
+     */
+    void stop_helpers();
+
+    /**
+     * @brief Decides whether a helper thread skips a given iteration
+     *
+     * Staggers helper threads over different depths, so that they fill the shared
+     * transposition table with useful entries instead of duplicating the main thread.
+     *
+     * @param depth Iteration about to be searched
+     * @return True if this thread should skip the iteration
+     */
+    bool skip_depth(int depth) const;
+
+    /**
+     * @brief Returns the number of search threads, main thread included
+     * @return Number of helpers plus one
+     */
+    int get_num_threads() const { return static_cast<int>(helpers.size()) + 1; }
+
+    /**
+     * @brief Returns the number of nodes searched by all threads
+     * @return Sum of the node counters of the main thread and its helpers
+     */
+    uint64_t get_total_nodes() const;
+
+    /**
+     * @brief Returns the search statistics of the last search
+     * @return Sum of the counters of the main thread and its helpers
+     */
+    SearchStats get_search_stats() const;
+
+    /**
+     * @brief Empties the evaluation caches of the main thread and its helpers
+     * 
+     * Cached evaluations become wrong when the evaluation function changes,
+     * e.g. when a network is loaded or unloaded.
+     */
+    void clear_eval_caches();
+
+    /**
+     * @brief Increments the node counter of this thread
+     *
+     * Only this thread writes its counter, so a relaxed load and store avoid
+     * the cost of an atomic read-modify-write.
+     */
+    void count_node() {
+        nodes.store(nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
     // Time management functions
     /**
      * @brief Checks if the search should be terminated based on limits
@@ -133,7 +221,8 @@ class Engine {
     /**
      * @brief Resets the engine to initial state for a new game
      * 
-     * called when receiving ucinewgame UCI instruction
+     * called when receiving ucinewgame UCI instruction. The hash table is aged rather
+     * than cleared: entries of the previous game are replaced first but stay usable.
      */
     void reset();
 
@@ -159,18 +248,37 @@ class Engine {
     SearchInfo search_info[MAX_PLY + 4];
 
     // Search statistics and state
-    // Total nodes searched
-    uint64_t nodes = 0;
+    // Total nodes searched by this thread
+    std::atomic<uint64_t> nodes = 0;
+    // Transposition table probes and hits of this thread, for bench reports
+    uint64_t tt_probes = 0;
+    uint64_t tt_hits   = 0;
+    // Last iteration this thread searched to completion
+    int completed_depth = 0;
+    // Pruning and cutoff counters of the last search, empty unless built with STATS=1
+    [[no_unique_address]] SearchStats stats;
     // Current position
-    Board board;
+    Position board;
     // Search limits
     Limits limits;
     // Search termination flag
-    bool stop_search = false;
+    std::atomic<bool> stop_search = false;
     // Search start time
     std::chrono::high_resolution_clock::time_point starttime;
-    // Transposition table
-    TranspositionTable tt{};
+    // Transposition table, shared between the main thread and its helpers
+    std::shared_ptr<TranspositionTable> tt;
+    // Pawn and material hash tables, private to the thread
+    EvalTables eval_tables;
+    // Static evaluation cache, private to the thread
+    EvalCache eval_cache;
     // Debug output flag
     bool debug = true;
+
+    // Lazy SMP state
+    // Thread index, 0 for the main thread
+    int thread_id = 0;
+    // Helper engines, only populated on the main thread
+    std::vector<std::unique_ptr<Engine>> helpers;
+    // Threads running the helper engines during a search
+    std::vector<std::thread> helper_threads;
 };
@@ -1,34 +1,88 @@
 #include "evaluate.h"
 
 
-int evaluate(Board board) {
-    bool white_to_move = board.sideToMove() == Color::WHITE;
-    int  mg_score      = 0;
-    int  eg_score      = 0;
-    int  game_phase    = 0;
+/**
+ * @brief Scales the evaluation down as the fifty-move rule approaches
+ * @param pos Current board position
+ * @param eval Evaluation of the position
+ * @return Adjusted evaluation
+ */
+static int adjust_for_halfmove_clock(const Position& pos, int eval) {
+    if (pos.halfMoveClock() > 40)
+        eval = eval * (100 - pos.halfMoveClock()) / 100;
+
+    return eval;
+}
+
+/**
+ * @brief Evaluates a position, before the half-move clock adjustment
+ * @param pos Current board position
+ * @param tables Evaluation hash tables of the calling thread
+ * @return Static evaluation score in centipawns
+ */
+static int evaluate_unadjusted(const Position& pos, EvalTables& tables) {
+    const MaterialEntry& material = tables.material.probe(pos);
+
+    if (material.endgame)
+        return material.endgame(pos, material.strong);
+
+    return pos.nnue_enabled() ? nnue::evaluate(pos.accumulator(), pos.sideToMove())
+                              : evaluate_classical(pos, tables, material);
+}
+
+int evaluate(const Position& pos, EvalTables& tables) {
+    return adjust_for_halfmove_clock(pos, evaluate_unadjusted(pos, tables));
+}
+
+int evaluate(const Position& pos, EvalTables& tables, EvalCache& eval_cache) {
+    int eval;
+
+    if (!eval_cache.probe(pos.hash(), eval))
+    {
+        eval = evaluate_unadjusted(pos, tables);
+        eval_cache.store(pos.hash(), eval);
+    }
+
+    return adjust_for_halfmove_clock(pos, eval);
+}
+
+int evaluate_classical(const Position& pos, EvalTables& tables, const MaterialEntry& material) {
+    bool white_to_move = pos.sideToMove() == Color::WHITE;
+
+    // Material Score, kept up to date by the position
+    int mg_score = pos.mg_score();
+    int eg_score = pos.eg_score();
+
+    // Game phase, 24 for a full set of pieces on both sides
+    int game_phase = material.phase;
 
-    // Material Score
-    calculate_material_score(board, mg_score, eg_score, game_phase);
+    // Pawn structure score, cached by pawn key
+    const PawnEntry& pawns = tables.pawns.probe(pos);
+    mg_score += pawns.mg_score;
+    eg_score += pawns.eg_score;
+
+    // Bishop pair bonus
+    calculate_bishop_pair_score(pos, mg_score, eg_score);
 
     // Mobility score
-    calculate_mobility_score(board, mg_score, eg_score);
+    calculate_mobility_score(pos, mg_score, eg_score);
 
     // Tempo bonus for the side to move
     mg_score += white_to_move ? 28 : -28;
 
+    // Endgame scaling, for material the side ahead can hardly convert
+    int scale = material.scale[eg_score > 0 ? 0 : 1];
+    if (material.bishops_only)
+        scale = std::min(scale, scale_opposite_bishops(pos));
+    eg_score = eg_score * scale / SCALE_NORMAL;
+
     // Phase interpolation
     int eval = (mg_score * game_phase + eg_score * (24 - game_phase)) / 24;
 
-    // half-move clock adjustment
-    if (board.halfMoveClock() > 40)
-        eval = eval * (100 - board.halfMoveClock()) / 100;
-
     return (white_to_move) ? eval : -eval;
 }
 
 void calculate_material_score(const Board& board, int& mg_score, int& eg_score, int& game_phase) {
-    static constexpr std::array<int, 6> game_phase_inc = {0, 1, 1, 2, 4, 0};
-
     for (Color color : {Color::WHITE, Color::BLACK})
     {
         int color_sign = (color == Color::WHITE) ? 1 : -1;
@@ -39,13 +93,6 @@ void calculate_material_score(const Board& board, int& mg_score, int& eg_score,
             int      pt_idx = static_cast<int>(pt);
             Bitboard pieces = board.pieces(pt, color);
 
-            // bonus for bishop pair
-            if (pt == PieceType::BISHOP && pieces.count() >= 2)
-            {
-                mg_score += color_sign * 30;
-                eg_score += color_sign * 50;
-            }
-
             while (pieces)
             {
                 uint8_t sq     = pieces.pop();
@@ -55,14 +102,25 @@ void calculate_material_score(const Board& board, int& mg_score, int& eg_score,
                 eg_score += color_sign * pst::eg_table[pt_idx][sq_idx];
 
                 // calculate game phase while counting scores
-                game_phase += game_phase_inc[pt_idx];
+                game_phase += pst::game_phase_inc[pt_idx];
             }
         }
     }
+}
 
-    // 24 corresponds to a full set of pieces on both sides without promotions
-    game_phase = std::min(game_phase, 24);
+void calculate_bishop_pair_score(const Board& board, int& mg_score, int& eg_score) {
+    for (Color color : {Color::WHITE, Color::BLACK})
+    {
+        int color_sign = (color == Color::WHITE) ? 1 : -1;
+
+        if (board.pieces(PieceType::BISHOP, color).count() >= 2)
+        {
+            mg_score += color_sign * 30;
+            eg_score += color_sign * 50;
+        }
+    }
 }
+
 void calculate_mobility_score(const Board& board, int& mg_score, int& eg_score) {
     for (Color color : {Color::WHITE, Color::BLACK})
     {
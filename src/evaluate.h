@@ -1,22 +1,69 @@
 #pragma once
 #include "chess.hpp"
 #include "arrays.h"
+#include "material.h"
+#include "pawns.h"
+#include "position.h"
 
 using namespace chess;
 
+/**
+ * @struct EvalTables
+ * @brief Hash tables of the hand-crafted evaluation, one set per search thread
+ */
+struct EvalTables {
+    PawnTable     pawns;
+    MaterialTable material;
+};
+
 /**
  * @brief Evaluates the current board position
  * 
- * @param board Current board position
+ * Known endgames are handed to their specialised evaluation function. Otherwise,
+ * uses the NNUE network when one is loaded, the hand-crafted evaluation otherwise.
+ * 
+ * @param pos Current board position
+ * @param tables Evaluation hash tables of the calling thread
+ * @return Static evaluation score in centipawns
+ */
+int evaluate(const Position& pos, EvalTables& tables);
+
+/**
+ * @brief Evaluates the current board position, through an evaluation cache
+ * 
+ * Same result as evaluate(), but positions already met by the thread are read from
+ * its cache instead of being evaluated again. The half-move clock adjustment is
+ * applied after the lookup, since the hash key does not depend on the clock.
+ * 
+ * @param pos Current board position
+ * @param tables Evaluation hash tables of the calling thread
+ * @param eval_cache Evaluation cache of the calling thread
  * @return Static evaluation score in centipawns
  */
-int evaluate(Board board);
+int evaluate(const Position& pos, EvalTables& tables, EvalCache& eval_cache);
+
+/**
+ * @brief Hand-crafted evaluation of the current board position
+ * 
+ * Material and piece-square table scores are read from the incrementally updated
+ * accumulators of the position.
+ * 
+ * The pawn structure terms are looked up in the pawn hash table, the game phase and
+ * the endgame scale factor in the material table.
+ * 
+ * @param pos Current board position
+ * @param tables Evaluation hash tables of the calling thread
+ * @param material Material table entry of the position
+ * @return Static evaluation score in centipawns, from the side to move's perspective
+ */
+int evaluate_classical(const Position& pos, EvalTables& tables, const MaterialEntry& material);
 
 /**
- * @brief Calculates material and piece-square table scores
+ * @brief Calculates material and piece-square table scores from scratch
  * 
  * Updates both middlegame and endgame scores based on piece values and their positions.
  * Also tracks the game phase which is used to interpolate between middlegame and endgame scores.
+ * Only used to initialize the accumulators of a Position, which are then updated incrementally.
  * 
  * @param board Current board position
  * @param mg_score Reference to middlegame score to be updated
@@ -25,6 +72,15 @@ int evaluate(Board board);
  */
 void calculate_material_score(const Board& board, int& mg_score, int& eg_score, int& game_phase);
 
+/**
+ * @brief Calculates the bishop pair bonus
+ * 
+ * @param board Current board position
+ * @param mg_score Reference to middlegame score to be updated
+ * @param eg_score Reference to endgame score to be updated
+ */
+void calculate_bishop_pair_score(const Board& board, int& mg_score, int& eg_score);
+
 /**
  * @brief Calculates mobility scores for pieces
  * 
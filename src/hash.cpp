@@ -1,46 +1,415 @@
 #include "hash.h"
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
 
-uint32_t TranspositionTable::index(uint64_t key) {
-#ifdef __SIZEOF_INT128__
-    return (uint64_t) (((__uint128_t) key * (__uint128_t) table.size()) >> 64);
-#else
-    return key % entries_.size();
+#if defined(__linux__)
+    #include <fcntl.h>
+    #include <linux/mempolicy.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#elif defined(_WIN32)
+    #include <malloc.h>
 #endif
+
+/**
+ * @class ZobristExtractor
+ * @brief Empty board giving access to the protected members needed to read the keys
+ */
+class ZobristExtractor : public Board {
+   public:
+    ZobristExtractor() {
+        Bitboard occupied = occ();
+        while (occupied)
+        {
+            Square sq = occupied.pop();
+            removePiece(at(sq), sq);
+        }
+
+        cr_.clear();
+        ep_sq_ = Square::NO_SQ;
+        stm_   = Color::BLACK;
+    }
+
+    // An empty board with black to move hashes to 0, so each key is read in isolation
+    void extract(ZobristKeys& keys) {
+        for (int piece = 0; piece < 12; piece++)
+            for (int sq = 0; sq < 64; sq++)
+            {
+                Piece p = Piece(static_cast<Piece::underlying>(piece));
+                placePiece(p, Square(sq));
+                keys.piece[piece][sq] = zobrist();
+                removePiece(p, Square(sq));
+            }
+
+        for (int file = 0; file < 8; file++)
+        {
+            ep_sq_               = Square(File(file), Rank::RANK_3);
+            keys.enpassant[file] = zobrist();
+        }
+        ep_sq_ = Square::NO_SQ;
+
+        stm_      = Color::WHITE;
+        keys.side = zobrist();
+        stm_      = Color::BLACK;
+    }
+};
+
+ZobristKeys::ZobristKeys() { ZobristExtractor().extract(*this); }
+
+const ZobristKeys zobrist_keys;
+
+
+uint8_t TTEntry::relative_age(uint8_t generation8) const {
+    // Adding GENERATION_CYCLE keeps the result positive when the generation wraps around
+    return (TranspositionTable::GENERATION_CYCLE + generation8 - genbound8)
+         & TranspositionTable::GENERATION_MASK;
 }
 
 
 void TranspositionTable::store(uint64_t key, int depth, int score, Move move, Bound bound) {
-    TTEntry* tte = &table[index(key)];
+    TTBucket& bucket = table[index(key)];
+    uint16_t  key16  = static_cast<uint16_t>(key);
+    int       slot   = 0;
+    TTEntry   tte    = bucket.load(0);
+
+    // Look for the same position first, then for the least valuable entry:
+    // empty entries first, then the shallowest ones, older searches counting as shallower
+    for (int i = 0; i < TTBucket::ENTRIES; i++)
+    {
+        TTEntry entry = i == 0 ? tte : bucket.load(i);
+
+        if (entry.key16 == key16 || entry.bound() == BOUND_NONE)
+        {
+            slot = i;
+            tte  = entry;
+            break;
+        }
+
+        // the age counts GENERATION_DELTA per search, so one search of age costs 8 plies
+        if (tte.depth8 - 2 * tte.relative_age(generation8)
+            > entry.depth8 - 2 * entry.relative_age(generation8))
+        {
+            slot = i;
+            tte  = entry;
+        }
+    }
+
+    if (tte.key16 != key16 || move != Move::NO_MOVE)
+        tte.move16 = move.move();
+
+    if (tte.key16 != key16 || bound == BOUND_EXACT || depth + 2 > tte.depth8
+        || tte.relative_age(generation8))
+    {
+        tte.key16     = key16;
+        tte.depth8    = static_cast<uint8_t>(depth);
+        tte.score16   = static_cast<int16_t>(score);
+        tte.genbound8 = static_cast<uint8_t>(generation8 | bound);
+    }
+
+    bucket.save(slot, tte);
+}
+
+
+TTEntry TranspositionTable::probe(uint64_t key, Move& ttmove, bool& tt_hit) const {
+    const TTBucket& bucket = table[index(key)];
+    uint16_t        key16  = static_cast<uint16_t>(key);
+
+    for (int i = 0; i < TTBucket::ENTRIES; i++)
+    {
+        // Work on a single snapshot of the entry, which another thread may overwrite
+        TTEntry entry = bucket.load(i);
+
+        if (entry.key16 == key16 && entry.bound() != BOUND_NONE)
+        {
+            tt_hit = true;
+            ttmove = entry.move();
+            return entry;
+        }
+    }
+
+    tt_hit = false;
+    ttmove = Move::NO_MOVE;
+    return TTEntry{};
+}
+
+
+void TranspositionTable::clear(int num_threads) {
+    loaded = false;
+
+    std::vector<std::thread> threads;
+    uint64_t                 chunk = bucket_count / num_threads;
+
+    for (int i = 0; i < num_threads; i++)
+    {
+        uint64_t start = i * chunk;
+        uint64_t end   = (i == num_threads - 1) ? bucket_count : start + chunk;
+
+        threads.emplace_back([this, start, end]() {
+            std::memset(static_cast<void*>(&table[start]), 0, (end - start) * sizeof(TTBucket));
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    generation8 = 0;
+}
+
+
+void TranspositionTable::new_search() { generation8 += GENERATION_DELTA; }
+
+
+int TranspositionTable::hashfull() const {
+    constexpr int SAMPLE_BUCKETS = 1000 / TTBucket::ENTRIES;
+
+    int count = 0;
+    for (int i = 0; i < SAMPLE_BUCKETS; i++)
+        for (int j = 0; j < TTBucket::ENTRIES; j++)
+        {
+            TTEntry entry = table[i].load(j);
+            count += entry.bound() != BOUND_NONE && entry.relative_age(generation8) == 0;
+        }
+
+    return count * 1000 / (SAMPLE_BUCKETS * TTBucket::ENTRIES);
+}
+
+
+TranspositionTable::TranspositionTable() { resize(DEFAULT_HASH_MiB); }
+
+
+TranspositionTable::~TranspositionTable() { deallocate(); }
+
+
+/**
+ * @brief Counts the NUMA nodes of the machine
+ * @return Number of nodes exposed by the kernel, 1 if unknown
+ */
+static int count_numa_nodes() {
+    int nodes = 0;
+
+#if defined(__linux__)
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", ec))
+    {
+        const std::string name = entry.path().filename().string();
+        if (name.rfind("node", 0) == 0 && name.size() > 4 && std::isdigit(name[4]))
+            nodes++;
+    }
+#endif
+
+    return std::max(nodes, 1);
+}
+
+
+/**
+ * @brief Tells whether the kernel backs madvise(MADV_HUGEPAGE) regions with huge pages
+ * 
+ * madvise() succeeds even when the policy is [never], so the sysfs setting is read instead.
+ * 
+ * @return True if the transparent huge page policy is [always] or [madvise]
+ */
+[[maybe_unused]] static bool transparent_huge_pages_enabled() {
+    std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+    std::string   policy;
+
+    if (!std::getline(file, policy))
+        return false;
+
+    return policy.find("[always]") != std::string::npos
+        || policy.find("[madvise]") != std::string::npos;
+}
+
+
+void TranspositionTable::allocate(uint64_t size, int num_threads) {
+    // free the previous table first, so that both never coexist in memory
+    deallocate();
+
+    size_t bytes = size * sizeof(TTBucket);
+
+#if defined(__linux__)
+    // round up to a whole number of huge pages, as required by aligned_alloc
+    size_t alloc_bytes = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
 
-    if (tte->key != key || move != Move::NO_MOVE)
-        tte->move = move;
+    table = static_cast<TTBucket*>(std::aligned_alloc(HUGE_PAGE_SIZE, alloc_bytes));
 
-    if (tte->key != key || bound == BOUND_EXACT || depth + 2 > tte->depth)
+    bool huge_pages = madvise(table, alloc_bytes, MADV_HUGEPAGE) == 0
+                   && transparent_huge_pages_enabled();
+    alloc_mode      = huge_pages ? "transparent huge pages" : "4 KiB pages";
+
+    // Spread the pages over every NUMA node, so that all threads share the memory bandwidth.
+    // The policy only applies to pages not touched yet, which clear() does right after.
+    int numa_nodes = count_numa_nodes();
+    if (num_threads > 1 && numa_nodes > 1)
     {
-        tte->key   = key;
-        tte->depth = depth;
-        tte->score = score;
-        tte->bound = bound;
+        unsigned long nodemask = numa_nodes >= 64 ? ~0ul : (1ul << numa_nodes) - 1;
+        if (syscall(SYS_mbind, table, alloc_bytes, MPOL_INTERLEAVE, &nodemask, 64, 0) == 0)
+            alloc_mode += ", interleaved over " + std::to_string(numa_nodes) + " numa nodes";
     }
+#elif defined(_WIN32)
+    table      = static_cast<TTBucket*>(_aligned_malloc(bytes, alignof(TTBucket)));
+    alloc_mode = "4 KiB pages";
+#else
+    table      = static_cast<TTBucket*>(std::aligned_alloc(alignof(TTBucket), bytes));
+    alloc_mode = "4 KiB pages";
+#endif
+
+    if (!table)
+    {
+        std::cerr << "failed to allocate " << bytes << " bytes for the hash table" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    bucket_count = size;
 }
 
 
-TTEntry* TranspositionTable::probe(uint64_t key, Move& ttmove, bool& tt_hit) {
-    TTEntry* tte = &table[index(key)];
-    tt_hit       = (tte->key == key);
-    ttmove       = tte->move;
-    return tte;
+void TranspositionTable::deallocate() {
+#if defined(__linux__)
+    if (mapping)
+        munmap(mapping, mapping_size);
+    else
+        std::free(table);
+
+    mapping      = nullptr;
+    mapping_size = 0;
+#elif defined(_WIN32)
+    _aligned_free(table);
+#else
+    std::free(table);
+#endif
+
+    table        = nullptr;
+    bucket_count = 0;
+    loaded       = false;
 }
 
 
-void TranspositionTable::clear() { std::fill(table.begin(), table.end(), TTEntry()); }
+void TranspositionTable::resize(uint64_t size_mib, int num_threads) {
+    this->size_mib = size_mib;
+    allocate(size_mib * 1024 * 1024 / sizeof(TTBucket), num_threads);
+
+    // the search may use a single thread, zeroing the table is still worth every core
+    clear(std::max<int>(num_threads, std::thread::hardware_concurrency()));
+}
 
 
-TranspositionTable::TranspositionTable() { allocateMB(64); }
+/**
+ * @struct TTFileHeader
+ * @brief Header of a saved table, rejecting files written with another entry layout
+ * 
+ * Its size keeps the buckets that follow it aligned on cache lines.
+ */
+struct TTFileHeader {
+    static constexpr char     MAGIC[8] = {'C', 'H', 'I', 'M', 'P', 'T', 'T', '\0'};
+    static constexpr uint32_t VERSION  = 1;  // bump whenever TTEntry changes meaning
+    static constexpr uint32_t ENDIAN   = 0x01020304;
 
+    char     magic[8];
+    uint32_t version;
+    uint32_t endian;
+    uint32_t entry_size;
+    uint32_t bucket_size;
+    uint64_t bucket_count;
+    uint8_t  generation8;
+    uint8_t  padding[31];
 
-void TranspositionTable::allocateMB(uint64_t size_mb) {
-    uint64_t sizeB = size_mb * static_cast<int>(1e6);
-    table.resize(sizeB / sizeof(TTEntry));
-    std::cout << "hash set to " << sizeB / 1e6 << " MB" << std::endl;
-}
\ No newline at end of file
+    bool matches_layout() const {
+        return std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0 && version == VERSION
+            && endian == ENDIAN && entry_size == sizeof(TTEntry)
+            && bucket_size == sizeof(TTBucket) && bucket_count > 0;
+    }
+};
+
+static_assert(sizeof(TTFileHeader) == sizeof(TTBucket), "buckets must stay cache-line aligned");
+
+
+bool TranspositionTable::save(const std::string& path) const {
+    TTFileHeader header{};
+    std::memcpy(header.magic, TTFileHeader::MAGIC, sizeof(header.magic));
+    header.version      = TTFileHeader::VERSION;
+    header.endian       = TTFileHeader::ENDIAN;
+    header.entry_size   = sizeof(TTEntry);
+    header.bucket_size  = sizeof(TTBucket);
+    header.bucket_count = bucket_count;
+    header.generation8  = generation8;
+
+    // written next to the target then renamed over it: the target may be the file this
+    // table is mapped from, which must not be truncated while its pages are still in use
+    const std::string tmp_path = path + ".tmp";
+
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(table), bucket_count * sizeof(TTBucket));
+    file.close();
+
+    std::error_code ec;
+    if (!file.fail())
+        std::filesystem::rename(tmp_path, path, ec);
+
+    if (file.fail() || ec)
+    {
+        std::filesystem::remove(tmp_path, ec);
+        return false;
+    }
+
+    return true;
+}
+
+
+bool TranspositionTable::load(const std::string& path) {
+    TTFileHeader header;
+    std::ifstream file(path, std::ios::binary);
+
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || !header.matches_layout())
+        return false;
+
+    std::error_code ec;
+    const size_t    file_size = std::filesystem::file_size(path, ec);
+    const size_t    data_size = header.bucket_count * sizeof(TTBucket);
+    const uint64_t  data_mib  = data_size / (1024 * 1024);
+
+    if (ec || file_size != sizeof(header) + data_size || data_mib < MINHASH_MiB
+        || data_mib > MAXHASH_MiB)
+        return false;
+
+#if defined(__linux__)
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    // private mapping: the search writes to copies of the pages, never to the file
+    void* base = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED)
+        return false;
+
+    deallocate();
+    mapping      = base;
+    mapping_size = file_size;
+    table        = reinterpret_cast<TTBucket*>(static_cast<char*>(base) + sizeof(header));
+    bucket_count = header.bucket_count;
+    alloc_mode   = "copy-on-write mapping of " + path;
+#else
+    allocate(header.bucket_count);
+
+    if (!file.read(reinterpret_cast<char*>(table), data_size))
+    {
+        size_mib = data_mib;
+        clear();
+        return false;
+    }
+#endif
+
+    size_mib    = data_mib;
+    generation8 = header.generation8;
+    loaded      = true;
+    return true;
+}
@@ -1,33 +1,135 @@
 #pragma once
 #include "chess.hpp"
 #include "types.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <string>
+#include <vector>
 
 using namespace chess;
 
 /**
  * @struct TTEntry
- * @brief Transposition table entry storing search results for a position
+ * @brief Compressed transposition table entry storing search results for a position
  * 
- * Each entry contains information about a previously searched position,
- * including the Zobrist hash key, search depth, score, best move, and
- * the type of bound (exact, upper, or lower).
+ * Each entry packs, into 8 bytes, the lower 16 bits of the Zobrist hash key,
+ * the best move, the score, the search depth, and the generation of the search
+ * that stored it together with the type of bound (exact, upper, or lower).
+ * 
+ * Entries are only ever read and written as whole 64-bit words, see TTBucket.
  */
 struct TTEntry {
-    uint64_t key   = 0;
-    int      depth = 0;
-    int      score = 0;
-    Move     move  = Move::NO_MOVE;
-    Bound    bound = BOUND_NONE;
+    // no default member initializers, so that large tables are allocated without being
+    // touched and zeroed afterwards by TranspositionTable::clear()
+    uint16_t key16;
+    uint16_t move16;
+    int16_t  score16;
+    uint8_t  depth8;
+    uint8_t  genbound8;  // generation in the upper 6 bits, bound in the lower 2 bits
+
+    Move  move() const { return Move(move16); }
+    int   score() const { return score16; }
+    int   depth() const { return depth8; }
+    Bound bound() const { return Bound(genbound8 & 0x3); }
+
+    /**
+     * @brief Computes how many searches ago this entry was stored
+     * @param generation8 Generation of the current search
+     * @return Age of the entry as a raw generation difference, i.e. GENERATION_DELTA (4)
+     * per search, so that replacement weighs each search of age as 8 plies of depth
+     */
+    uint8_t relative_age(uint8_t generation8) const;
 };
 
+static_assert(sizeof(TTEntry) == 8, "TTEntry must be 8 bytes");
+
+/**
+ * @struct TTBucket
+ * @brief Cache-line sized group of entries sharing the same table index
+ * 
+ * A probe touches a single 64-byte line, and collisions evict the least valuable
+ * entry of the bucket instead of the only one of the slot.
+ * 
+ * Each entry is kept in a single atomic word, so that the key check and the data
+ * always come from the same store: concurrent writers from several search threads
+ * may overwrite each other, but never leave a torn entry behind.
+ */
+struct alignas(64) TTBucket {
+    static constexpr int ENTRIES = 8;
+
+    std::atomic<uint64_t> entries[ENTRIES];
+
+    TTEntry load(int i) const {
+        return std::bit_cast<TTEntry>(entries[i].load(std::memory_order_relaxed));
+    }
+
+    void save(int i, TTEntry tte) {
+        entries[i].store(std::bit_cast<uint64_t>(tte), std::memory_order_relaxed);
+    }
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "TT entries must be lock-free");
+static_assert(sizeof(TTBucket) == 64, "TTBucket must fit a cache line");
+
+/**
+ * @struct ZobristKeys
+ * @brief Copy of the Zobrist keys used by Board::hash()
+ * 
+ * The chess library keeps its keys private, so they are extracted once at startup
+ * through Board::zobrist(), to compute keys without making moves.
+ */
+struct ZobristKeys {
+    uint64_t piece[12][64];
+    uint64_t enpassant[8];
+    uint64_t side;
+
+    ZobristKeys();
+};
+
+extern const ZobristKeys zobrist_keys;
+
+/**
+ * @brief Computes the Zobrist hash key of the position reached after a move
+ * 
+ * Cheaper than making the move, but approximate: castling rights updates and new
+ * en passant squares are ignored, and castling only accounts for the king.
+ * Only meant to prefetch the transposition table.
+ * 
+ * @param board Current board position
+ * @param move Move about to be made
+ * @return Zobrist hash key of the position after the move
+ */
+inline uint64_t key_after(const Board& board, Move move) {
+    uint64_t key    = board.hash() ^ zobrist_keys.side;
+    Piece    moving = board.at(move.from());
+    Piece    target = board.at(move.to());
+
+    if (board.enpassantSq() != Square::NO_SQ)
+        key ^= zobrist_keys.enpassant[board.enpassantSq().file()];
+
+    if (target != Piece::NONE && move.typeOf() != Move::CASTLING)
+        key ^= zobrist_keys.piece[target][move.to().index()];
+
+    if (move.typeOf() == Move::ENPASSANT)
+        key ^= zobrist_keys.piece[Piece(PieceType::PAWN, ~moving.color())]
+                                 [move.to().ep_square().index()];
+
+    Piece placed =
+      move.typeOf() == Move::PROMOTION ? Piece(move.promotionType(), moving.color()) : moving;
+
+    return key ^ zobrist_keys.piece[moving][move.from().index()]
+         ^ zobrist_keys.piece[placed][move.to().index()];
+}
+
 /**
  * @class TranspositionTable
  * @brief Stores and retrieves search results for previously evaluated positions
  * 
  * The transposition table uses Zobrist hashing to identify positions and 
- * implements a replacement strategy to manage table entries efficiently.
+ * implements a depth and age preferred replacement strategy within each bucket.
  * 
- * Heavily inspired from smallbrain for now.
+ * Bucket layout and replacement scheme are inspired from Stockfish.
  */
 class TranspositionTable {
    public:
@@ -36,6 +138,28 @@ class TranspositionTable {
      */
     TranspositionTable();
 
+    /**
+     * @brief Releases the memory of the transposition table
+     */
+    ~TranspositionTable();
+
+    TranspositionTable(const TranspositionTable&)            = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    /**
+     * @brief Resizes the transposition table, discarding its content
+     * @param size_mib New size of the table in MiB
+     * @param num_threads Number of search threads, deciding the NUMA placement of the table.
+     *                    The new table is cleared with at least one thread per hardware thread.
+     */
+    void resize(uint64_t size_mib, int num_threads = 1);
+
+    /**
+     * @brief Returns the current size of the table
+     * @return Size of the table in MiB
+     */
+    uint64_t get_size_mib() const { return size_mib; }
+
     /**
      * @brief Stores a search result in the transposition table
      * @param key Zobrist hash key of the position
@@ -52,39 +176,201 @@ class TranspositionTable {
      * @param key Zobrist hash key of the position to look up
      * @param ttmove Reference to store the best move if found
      * @param tt_hit Reference to indicate whether a matching entry was found
-     * @return Pointer to the retrieved entry or nullptr if not found
+     * @return Copy of the retrieved entry, or an empty entry if not found
      */
-    TTEntry* probe(uint64_t key, Move& ttmove, bool& tt_hit);
+    TTEntry probe(uint64_t key, Move& ttmove, bool& tt_hit) const;
 
     /**
      * @brief Computes the index in the table for a given hash key
      * @param key Zobrist hash key
-     * @return Index in the table
+     * @return Index of the bucket in the table
      */
-    inline uint32_t index(uint64_t key);
+    uint32_t index(uint64_t key) const {
+#ifdef __SIZEOF_INT128__
+        return (uint64_t) (((__uint128_t) key * (__uint128_t) bucket_count) >> 64);
+#else
+        return key % bucket_count;
+#endif
+    }
 
     /**
-     * @brief Allocates memory for the transposition table
-     * @param size Number of entries to allocate
+     * @brief Starts loading the bucket of a position into the cache
+     * 
+     * Called before making a move, so that the memory latency of the child's probe
+     * overlaps with the work done until the child actually probes.
+     * 
+     * @param key Zobrist hash key of the position about to be searched
      */
-    void allocate(uint64_t size);
+    void prefetch(uint64_t key) const {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(&table[index(key)]);
+#endif
+    }
 
     /**
-    * @brief Allocates memory for the transposition table in megabytes
-    * @param size_mb Size of the table in megabytes
-    */
-    void allocateMB(uint64_t size_mb);
+     * @brief Allocates memory for the transposition table, leaving it uninitialized
+     * 
+     * On Linux, the table is backed by 2 MiB transparent huge pages to cut TLB misses,
+     * and its pages are interleaved across NUMA nodes when several threads search.
+     * Other platforms fall back to a cache-line aligned allocation.
+     * 
+     * @param size Number of buckets to allocate
+     * @param num_threads Number of threads that will probe the table
+     */
+    void allocate(uint64_t size, int num_threads = 1);
+
+    /**
+     * @brief Releases the memory of the transposition table
+     */
+    void deallocate();
+
+    /**
+     * @brief Describes how the table memory was allocated
+     * @return Human readable page size and NUMA placement of the table
+     */
+    const std::string& get_alloc_mode() const { return alloc_mode; }
+
+    /**
+     * @brief Tells whether the table still holds the entries restored by load()
+     * @return True until the table is cleared or reallocated
+     */
+    bool is_loaded() const { return loaded; }
 
     /**
     * @brief Clears all entries in the transposition table
+    * 
+    * The table is split in one contiguous chunk per thread, so that clearing
+    * a table of several gigabytes is bound by memory bandwidth only.
+    * 
+    * @param num_threads Number of threads zeroing the table
+    */
+    void clear(int num_threads = 1);
+
+    /**
+    * @brief Increments the generation, ageing every entry stored by previous searches
+    * 
+    * called once at the start of every search
+    */
+    void new_search();
+
+    /**
+    * @brief Estimates how full the table is, for the UCI hashfull field
+    * 
+    * Only the entries stored by the current search are counted, in a sample of the
+    * first buckets, so that the estimate is cheap enough to be printed every depth.
+    * 
+    * @return Per mille of the table used by the current search
+    */
+    int hashfull() const;
+
+    /**
+    * @brief Writes the whole table, preceded by a layout header, to a file
+    * @param path Path of the file to create or overwrite
+    * @return True if the file was written completely
     */
-    void clear();
+    bool save(const std::string& path) const;
 
     /**
-    * @brief Maximum allowed hash size in MiB
+    * @brief Replaces the table with the content of a file written by save()
+    * 
+    * On Linux, the file is memory-mapped copy-on-write instead of being read: loading
+    * is near-instant whatever its size, pages are faulted in by the search as needed,
+    * and the file itself is never modified. Elsewhere, the file is read into a new table.
+    * 
+    * @param path Path of the file to load
+    * @return True if the file matched the entry layout of this build and was loaded
     */
-    static constexpr uint64_t MAXHASH_MiB = (1ull << 32) * sizeof(TTEntry) / (1024 * 1024);
+    bool load(const std::string& path);
+
+    /**
+    * @brief Default, minimum and maximum allowed hash size in MiB
+    */
+    static constexpr uint64_t DEFAULT_HASH_MiB = 64;
+    static constexpr uint64_t MINHASH_MiB      = 1;
+    static constexpr uint64_t MAXHASH_MiB      = (1ull << 32) * sizeof(TTBucket) / (1024 * 1024);
+
+    // The lower 2 bits of genbound8 hold the bound, the generation counts in the upper 6 bits
+    static constexpr uint8_t  GENERATION_BITS  = 2;
+    static constexpr uint8_t  GENERATION_DELTA = (1 << GENERATION_BITS);
+    static constexpr int      GENERATION_CYCLE = 255 + GENERATION_DELTA;
+    static constexpr uint8_t  GENERATION_MASK  = (0xFF << GENERATION_BITS) & 0xFF;
+
+    /**
+    * @brief Alignment of the table allocation, the size of a huge page
+    */
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
 
    private:
-    std::vector<TTEntry> table;
-};
\ No newline at end of file
+    TTBucket*   table        = nullptr;
+    uint64_t    bucket_count = 0;
+    uint64_t    size_mib     = 0;
+    uint8_t     generation8  = 0;
+    std::string alloc_mode;
+    bool        loaded       = false;
+
+    // file mapping backing the table after load(), nullptr when the table is allocated
+    void*  mapping      = nullptr;
+    size_t mapping_size = 0;
+};
+
+/**
+ * @class EvalCache
+ * @brief Small per-thread cache of static evaluations, indexed by Zobrist hash key
+ * 
+ * Each entry packs the upper 48 bits of the key with the 16-bit evaluation in a
+ * single word, so that a hit needs one load and no separate validity flag.
+ */
+class EvalCache {
+   public:
+    /**
+     * @brief Allocates an empty cache
+     */
+    EvalCache() :
+        entries(SIZE, 0) {}
+
+    /**
+     * @brief Looks up the static evaluation of a position
+     * @param key Zobrist hash key of the position
+     * @param eval Reference receiving the cached evaluation on a hit
+     * @return True if the evaluation was found
+     */
+    bool probe(uint64_t key, int& eval) {
+        const uint64_t entry = entries[key & (SIZE - 1)];
+
+        probes++;
+        if ((entry ^ key) >> 16)
+            return false;
+
+        hits++;
+        eval = static_cast<int16_t>(entry & 0xFFFF);
+        return true;
+    }
+
+    /**
+     * @brief Stores the static evaluation of a position, replacing the previous one
+     * @param key Zobrist hash key of the position
+     * @param eval Static evaluation of the position
+     */
+    void store(uint64_t key, int eval) {
+        entries[key & (SIZE - 1)] = (key & ~0xFFFFull) | static_cast<uint16_t>(eval);
+    }
+
+    /**
+     * @brief Empties the cache, needed when the evaluation function changes
+     */
+    void clear() { std::fill(entries.begin(), entries.end(), 0); }
+
+    /**
+     * @brief Returns the share of probes answered by the cache
+     * @return Hit rate in percent since the cache was created
+     */
+    double hit_rate() const { return probes ? 100.0 * hits / probes : 0.0; }
+
+    // Number of entries, a power of two
+    static constexpr size_t SIZE = 65536;
+
+   private:
+    std::vector<uint64_t> entries;
+    uint64_t              hits   = 0;
+    uint64_t              probes = 0;
+};
@@ -1,11 +1,19 @@
 #include "uci.h"
 #include "bench.h"
+#include "bitbase.h"
 
 
 int main(int argc, char* argv[]) {
+    bitbase::init();
+
     if (argc > 1 && std::string(argv[1]) == "bench")
     {
-        bench::run();
+        std::string args;
+        for (int i = 2; i < argc; i++)
+            args += std::string(argv[i]) + " ";
+
+        std::istringstream is(args);
+        bench::command(is);
         return 0;
     }
 
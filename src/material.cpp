@@ -0,0 +1,100 @@
+#include "material.h"
+#include "arrays.h"
+#include <algorithm>
+
+/**
+ * @brief Reads the number of pieces of a kind from a material key
+ * @param key Material key of the position
+ * @param pt Type of the pieces
+ * @param color Color of the pieces
+ * @return Number of such pieces on the board
+ */
+static int count(uint64_t key, PieceType::underlying pt, Color color) {
+    return (key >> (4 * (6 * color + static_cast<int>(pt)))) & 0xF;
+}
+
+/**
+ * @brief Computes the middlegame value of the pieces of a side, pawns and king excluded
+ * @param key Material key of the position
+ * @param color Side to count the pieces of
+ * @return Non-pawn material of the side
+ */
+static int non_pawn_material(uint64_t key, Color color) {
+    int npm = 0;
+
+    for (auto pt : {PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK, PieceType::QUEEN})
+        npm += count(key, pt, color) * pst::mg_value[static_cast<int>(pt)];
+
+    return npm;
+}
+
+void analyse_material(uint64_t key, MaterialEntry& entry) {
+    static constexpr int KNIGHT_MG = pst::mg_value[static_cast<int>(PieceType::KNIGHT)];
+    static constexpr int BISHOP_MG = pst::mg_value[static_cast<int>(PieceType::BISHOP)];
+    static constexpr int ROOK_MG   = pst::mg_value[static_cast<int>(PieceType::ROOK)];
+
+    entry.key     = key;
+    entry.phase   = 0;
+    entry.endgame = nullptr;
+
+    for (auto pt : {PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK, PieceType::QUEEN})
+        for (Color color : {Color::WHITE, Color::BLACK})
+            entry.phase += count(key, pt, color) * pst::game_phase_inc[static_cast<int>(pt)];
+
+    entry.phase = std::min(entry.phase, 24);
+
+    for (Color strong : {Color::WHITE, Color::BLACK})
+    {
+        const Color weak         = ~strong;
+        const int   strong_npm   = non_pawn_material(key, strong);
+        const int   weak_npm     = non_pawn_material(key, weak);
+        const int   strong_pawns = count(key, PieceType::PAWN, strong);
+        const bool  weak_bare    = weak_npm == 0 && count(key, PieceType::PAWN, weak) == 0;
+
+        // SPECIALISED ENDGAMES
+        if (weak_bare && !entry.endgame)
+        {
+            entry.strong = strong;
+
+            if (strong_pawns == 0 && count(key, PieceType::BISHOP, strong) == 1
+                && count(key, PieceType::KNIGHT, strong) == 1
+                && strong_npm == BISHOP_MG + KNIGHT_MG)
+                entry.endgame = evaluate_kbnk;
+
+            else if (strong_npm >= ROOK_MG)
+                entry.endgame = evaluate_kxk;
+
+            else if (strong_npm == 0 && strong_pawns == 1)
+                entry.endgame = evaluate_kpk;
+        }
+
+        // SCALE FACTORS
+        // without pawns, a minor piece up is not enough to win
+        if (strong_pawns == 0 && strong_npm - weak_npm <= BISHOP_MG)
+            entry.scale[strong] = strong_npm < ROOK_MG ? SCALE_DRAW
+                                : weak_npm <= BISHOP_MG ? 4
+                                                        : 14;
+        else
+            entry.scale[strong] = SCALE_NORMAL;
+    }
+
+    entry.bishops_only = true;
+    for (Color color : {Color::WHITE, Color::BLACK})
+        entry.bishops_only &= count(key, PieceType::BISHOP, color) == 1
+                           && non_pawn_material(key, color) == BISHOP_MG;
+}
+
+MaterialTable::MaterialTable() :
+    entries(SIZE) {}
+
+const MaterialEntry& MaterialTable::probe(const Position& pos) {
+    const uint64_t key = pos.material_key();
+
+    // material keys are dense small integers, spread them before indexing
+    MaterialEntry& entry = entries[(key * 0x9E3779B97F4A7C15ull) >> (64 - SIZE_BITS)];
+
+    if (entry.key != key)
+        analyse_material(key, entry);
+
+    return entry;
+}
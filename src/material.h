@@ -0,0 +1,60 @@
+#pragma once
+#include "chess.hpp"
+#include "endgame.h"
+#include "position.h"
+#include <vector>
+
+using namespace chess;
+
+/**
+ * @struct MaterialEntry
+ * @brief Cached information about a material balance
+ * 
+ * Everything that only depends on the number of pieces of each kind is computed once
+ * per material key: the game phase, the endgame scale factors, and the specialised
+ * evaluation function of known endgames.
+ */
+struct MaterialEntry {
+    uint64_t  key     = 0;
+    int       phase   = 0;        // 24 for a full set of pieces, 0 for pawns and kings only
+    EndgameFn endgame = nullptr;  // specialised evaluation, nullptr for ordinary material
+    Color     strong;             // side the specialised evaluation is called for
+
+    // Scale factor of the endgame score when the indexed color is ahead, out of SCALE_NORMAL
+    uint8_t scale[2] = {SCALE_NORMAL, SCALE_NORMAL};
+    // Each side has a single bishop and no other piece, the bishops may be of opposite colours
+    bool bishops_only = false;
+};
+
+/**
+ * @class MaterialTable
+ * @brief Per-thread hash table of material balances, indexed by material key
+ */
+class MaterialTable {
+   public:
+    /**
+     * @brief Allocates an empty material table
+     */
+    MaterialTable();
+
+    /**
+     * @brief Looks up the material balance of a position, analysing it on a miss
+     * @param pos Current board position
+     * @return Entry holding the material information of the position
+     */
+    const MaterialEntry& probe(const Position& pos);
+
+    // Number of entries, a power of two
+    static constexpr int    SIZE_BITS = 13;
+    static constexpr size_t SIZE      = size_t(1) << SIZE_BITS;
+
+   private:
+    std::vector<MaterialEntry> entries;
+};
+
+/**
+ * @brief Analyses a material balance from scratch
+ * @param key Material key of the position, see Position::material_key()
+ * @param entry Entry receiving the material information
+ */
+void analyse_material(uint64_t key, MaterialEntry& entry);
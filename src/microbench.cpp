@@ -0,0 +1,223 @@
+#include "bench.h"
+#include "evaluate.h"
+#include "movepicker.h"
+#include "see.h"
+#include <algorithm>
+#include <iomanip>
+#include <random>
+#include <thread>
+#include <tuple>
+
+/**
+ * Times an operation and prints its median and minimum cost per call.
+ *
+ * @param name Name of the operation
+ * @param runs Number of timed runs, after the warm-up runs
+ * @param batch Performs one run and returns the number of calls it made
+ */
+template<typename Batch>
+static void time_op(const std::string& name, int runs, Batch&& batch) {
+    constexpr int WARMUP_RUNS = 3;
+
+    std::vector<double> samples;
+
+    for (int r = -WARMUP_RUNS; r < runs; r++)
+    {
+        auto     t0    = std::chrono::high_resolution_clock::now();
+        uint64_t calls = batch();
+        auto     t1    = std::chrono::high_resolution_clock::now();
+        auto     ns    = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+
+        if (r >= 0)
+            samples.push_back(double(ns) / std::max<uint64_t>(calls, 1));
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    std::cout << std::left << std::setw(26) << name << std::right << std::fixed
+              << std::setprecision(1) << " median " << std::setw(9) << samples[samples.size() / 2]
+              << " ns/op   min " << std::setw(9) << samples.front() << " ns/op" << std::endl;
+}
+
+void bench::micro(int runs) {
+    constexpr int ITERATIONS = 200;
+
+    std::vector<Position> positions(benchfens.begin(), benchfens.end());
+    std::vector<Movelist> legal(positions.size()), captures(positions.size());
+
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        movegen::legalmoves(legal[i], positions[i]);
+        movegen::legalmoves<movegen::MoveGenType::CAPTURE>(captures[i], positions[i]);
+    }
+
+    // keeps the results alive, so that the timed work cannot be optimised away
+    uint64_t sink = 0;
+
+    runs = std::max(1, runs);
+
+    time_op("movegen::legalmoves", runs, [&]() {
+        for (int it = 0; it < ITERATIONS; it++)
+            for (auto& pos : positions)
+            {
+                Movelist moves;
+                movegen::legalmoves(moves, pos);
+                sink += moves.size();
+            }
+        return uint64_t(ITERATIONS) * positions.size();
+    });
+
+    EvalTables tables;
+    time_op("evaluate", runs, [&]() {
+        for (int it = 0; it < ITERATIONS; it++)
+            for (auto& pos : positions)
+                sink += evaluate(pos, tables);
+        return uint64_t(ITERATIONS) * positions.size();
+    });
+
+    time_op("SEE", runs, [&]() {
+        uint64_t calls = 0;
+        for (int it = 0; it < ITERATIONS; it++)
+            for (size_t i = 0; i < positions.size(); i++)
+                for (const Move& move : captures[i])
+                {
+                    sink += SEE(positions[i], move, 0);
+                    calls++;
+                }
+        return calls;
+    });
+
+    // random keys spread over the whole table, as in a real search
+    TranspositionTable    tt;
+    std::vector<uint64_t> keys(1 << 16);
+    std::mt19937_64       rng(0);
+    for (auto& key : keys)
+        key = rng();
+
+    time_op("TranspositionTable::store", runs, [&]() {
+        for (size_t i = 0; i < keys.size(); i++)
+            tt.store(keys[i], int(i % 16), int(i % 100), Move::NO_MOVE, BOUND_LOWER);
+        return uint64_t(keys.size());
+    });
+
+    time_op("TranspositionTable::probe", runs, [&]() {
+        for (auto key : keys)
+        {
+            Move ttmove = Move::NO_MOVE;
+            bool tt_hit = false;
+            sink += tt.probe(key, ttmove, tt_hit).depth() + tt_hit;
+        }
+        return uint64_t(keys.size());
+    });
+
+    time_op("makeMove/unmakeMove", runs, [&]() {
+        uint64_t calls = 0;
+        for (int it = 0; it < ITERATIONS / 10; it++)
+            for (size_t i = 0; i < positions.size(); i++)
+                for (const Move& move : legal[i])
+                {
+                    positions[i].makeMove(move);
+                    sink += positions[i].hash();
+                    positions[i].unmakeMove(move);
+                    calls++;
+                }
+        return calls;
+    });
+
+    // empty killer, counter and history tables, as at the start of a search
+    Engine engine;
+    engine.debug = false;
+    engine.init_tables();
+    time_op("MovePicker::next_move", runs, [&]() {
+        uint64_t calls = 0;
+        for (auto& fen : benchfens)
+        {
+            engine.board.setFen(fen);
+            for (int it = 0; it < ITERATIONS / 10; it++)
+            {
+                MovePicker picker(engine, Move::NO_MOVE, 0);
+                Move       move;
+                while ((move = picker.next_move()) != Move::NO_MOVE)
+                {
+                    sink += move.move();
+                    calls++;
+                }
+            }
+        }
+        return calls;
+    });
+
+    std::cout << "checksum " << sink << std::endl;
+}
+
+/**
+ * Derives the fields of a stress test entry from its 16-bit key.
+ *
+ * @param key16 Lower 16 bits of the key
+ * @return Move, score, depth and bound that any entry with this key must hold
+ */
+static std::tuple<uint16_t, int, int, Bound> stress_fields(uint16_t key16) {
+    return {uint16_t(key16 * 40503u),
+            int(key16 * 7u % 20000) - 10000,
+            1 + key16 % 60,
+            Bound(1 + key16 % 3)};
+}
+
+bool bench::tt_stress(int threads, int iterations) {
+    TranspositionTable tt;
+    tt.resize(TranspositionTable::MINHASH_MiB);
+
+    // recently stored keys, shared so that threads probe each other's entries
+    constexpr int                      RECENT = 1024;
+    std::vector<std::atomic<uint64_t>> recent(RECENT);
+    std::atomic<uint64_t>              probes = 0, hits = 0, torn = 0;
+    std::vector<std::thread>           workers;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    for (int t = 0; t < threads; t++)
+        workers.emplace_back([&, t]() {
+            std::mt19937_64 rng(t);
+            uint64_t        local_hits = 0, local_torn = 0;
+
+            for (int i = 0; i < iterations; i++)
+            {
+                const uint64_t key                    = rng();
+                const auto [move16, score, depth, bd] = stress_fields(uint16_t(key));
+                tt.store(key, depth, score, Move(move16), bd);
+                recent[i % RECENT].store(key, std::memory_order_relaxed);
+
+                const uint64_t probe_key = recent[rng() % RECENT].load(std::memory_order_relaxed);
+                Move           ttmove    = Move::NO_MOVE;
+                bool           tt_hit    = false;
+                TTEntry        tte       = tt.probe(probe_key, ttmove, tt_hit);
+
+                if (!tt_hit)
+                    continue;
+
+                local_hits++;
+
+                // an entry matching the probed key16 must hold the fields of that key16
+                const auto [m, s, d, b] = stress_fields(uint16_t(probe_key));
+                if (tte.move16 != m || tte.score() != s || tte.depth() != d || tte.bound() != b
+                    || ttmove.move() != m)
+                    local_torn++;
+            }
+
+            probes += iterations;
+            hits += local_hits;
+            torn += local_torn;
+        });
+
+    for (auto& worker : workers)
+        worker.join();
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
+
+    std::cout << "ttstress: " << threads << " threads, " << probes << " stores and probes, "
+              << hits << " hits, " << torn << " torn entries, " << ms << " ms" << std::endl;
+    std::cout << (torn ? "ttstress FAILED" : "ttstress ok") << std::endl;
+
+    return torn == 0;
+}
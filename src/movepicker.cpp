@@ -1,27 +1,37 @@
 #include "movepicker.h"
 
-MovePicker::MovePicker(const Engine& engine, Movelist& moves, Move ttmove, int ply) :
+MovePicker::MovePicker(const Engine& engine, Move ttmove, int ply) :
     engine(engine),
-    movelist(moves),
     ttmove(ttmove),
-    ply(ply) {}
+    ply(ply),
+    captures_only(false) {}
+
+MovePicker::MovePicker(const Engine& engine, Move ttmove) :
+    engine(engine),
+    ttmove(ttmove),
+    ply(0),
+    captures_only(true) {}
 
 Move MovePicker::next_move() {
     switch (phase)
     {
     case Phase::TT :
-        phase = Phase::SCORE;
+        phase = Phase::GEN_CAPTURES;
 
-        if (ttmove != Move::NO_MOVE && is_in_movelist(ttmove))
+        if (ttmove != Move::NO_MOVE
+            && (captures_only ? is_legal<movegen::MoveGenType::CAPTURE>(ttmove)
+                              : is_legal<movegen::MoveGenType::ALL>(ttmove)))
             return ttmove;
 
+        ttmove = Move::NO_MOVE;
         [[fallthrough]];
 
-    case Phase::SCORE :
+    case Phase::GEN_CAPTURES :
         phase = Phase::CAPTURES;
 
-        // Score all moves before starting to pick them
-        score_moves();
+        movegen::legalmoves<movegen::MoveGenType::CAPTURE>(movelist, engine.board);
+        score_captures();
+        index = 0;
 
         [[fallthrough]];
 
@@ -30,10 +40,6 @@ Move MovePicker::next_move() {
         {
             int best_idx = find_best_from(index);
 
-            // If we've exhausted all captures, move to next phase
-            if (movelist[best_idx].score() < SCORE_CAPTURE)
-                break;
-
             std::swap(movelist[index], movelist[best_idx]);
 
             if (movelist[index] != ttmove)
@@ -42,32 +48,55 @@ Move MovePicker::next_move() {
             index++;
         }
 
+        if (captures_only)
+        {
+            phase = Phase::DONE;
+            return Move::NO_MOVE;
+        }
+
         phase = Phase::KILLER1;
         [[fallthrough]];
 
     case Phase::KILLER1 :
         phase = Phase::KILLER2;
 
-        if (killer1 != Move::NO_MOVE && killer1 != ttmove)
+        killer1 = engine.killer_moves[ply][0];
+        if (killer1 != Move::NO_MOVE && killer1 != ttmove
+            && is_legal<movegen::MoveGenType::QUIET>(killer1))
             return killer1;
 
+        killer1 = Move::NO_MOVE;
         [[fallthrough]];
 
     case Phase::KILLER2 :
-        phase = Phase::QUIET;
+        phase = Phase::COUNTER;
 
-        if (killer2 != Move::NO_MOVE && killer2 != ttmove && killer2 != killer1)
+        killer2 = engine.killer_moves[ply][1];
+        if (killer2 != Move::NO_MOVE && killer2 != ttmove && killer2 != killer1
+            && is_legal<movegen::MoveGenType::QUIET>(killer2))
             return killer2;
 
+        killer2 = Move::NO_MOVE;
         [[fallthrough]];
 
     case Phase::COUNTER :
-        phase = Phase::QUIET;
+        phase = Phase::GEN_QUIETS;
 
         if (counter != Move::NO_MOVE && counter != ttmove && counter != killer1
             && counter != killer2)
             return counter;
 
+        [[fallthrough]];
+
+    case Phase::GEN_QUIETS :
+        phase = Phase::QUIET;
+
+        movegen::legalmoves<movegen::MoveGenType::QUIET>(movelist, engine.board);
+        score_quiets();
+        index = 0;
+
+        [[fallthrough]];
+
     case Phase::QUIET :
         while (index < movelist.size())
         {
@@ -82,6 +111,7 @@ Move MovePicker::next_move() {
             index++;
         }
 
+        phase = Phase::DONE;
         return Move::NO_MOVE;
 
     default :
@@ -99,59 +129,31 @@ int MovePicker::find_best_from(int start_idx) {
     return best_idx;
 }
 
+template<movegen::MoveGenType mt>
+bool MovePicker::is_legal(Move move) const {
+    const PieceType pt = engine.board.at<PieceType>(move.from());
+    if (pt == PieceType::NONE)
+        return false;
+
+    Movelist candidates;
+    movegen::legalmoves<mt>(candidates, engine.board, 1 << int(pt));
 
-bool MovePicker::is_in_movelist(Move move) const {
-    return std::find(movelist.begin(), movelist.end(), move) != movelist.end();
+    return std::find(candidates.begin(), candidates.end(), move) != candidates.end();
 }
 
-void MovePicker::score_moves() {
+void MovePicker::score_captures() {
     for (auto& move : movelist)
-    {
-        int16_t score = 0;
-
-        // Score captures using MVV-LVA
-        if (engine.board.isCapture(move))
-            score = SCORE_CAPTURE + get_mvvlva_score(move);
-
-        // Score killer moves
-        else if (move == engine.killer_moves[ply][0])
-        {
-            killer1 = move;
-            score   = SCORE_KILLER1;
-        }
-        else if (move == engine.killer_moves[ply][1])
-        {
-            killer2 = move;
-            score   = SCORE_KILLER2;
-        }
+        move.setScore(SCORE_CAPTURE + get_mvvlva_score(move));
+}
 
-        // Score quiet moves
-        else
-        {
+void MovePicker::score_quiets() {
+    const int side = engine.board.sideToMove();
 
-            // // Score counter moves
-            // if (ply > 0)
-            // {
-            //     Move prevmove = engine.search_info[ply - 1].currmove;
-            //     if (prevmove != Move::NO_MOVE
-            //         && move == engine.counter_moves[prevmove.from().index()][prevmove.to().index()])
-            //     {
-            //         counter = move;
-            //         score   = SCORE_COUNTER;
-            //     }
-            // }
-
-            // // Score remaining quiet moves
-            // else
-            // {
-            int side     = engine.board.sideToMove();
-            int from_idx = move.from().index();
-            int to_idx   = move.to().index();
-            score        = engine.history_table[side][from_idx][to_idx];
-            //     }
-        }
-
-        move.setScore(score);
+    for (auto& move : movelist)
+    {
+        int from_idx = move.from().index();
+        int to_idx   = move.to().index();
+        move.setScore(engine.history_table[side][from_idx][to_idx]);
     }
 }
 
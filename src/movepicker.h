@@ -18,8 +18,9 @@ enum MoveScore : int16_t {
  * @class MovePicker
  * @brief Efficiently picks moves in optimal order for alpha-beta pruning
  * 
- * Implements a move ordering strategy based on:
- * 1. TT move
+ * Moves are generated lazily, one stage at a time, so that a node which
+ * cuts off early never pays for the generation of later stages:
+ * 1. TT move (validated without generating the full move list)
  * 2. Captures sorted by MVV-LVA
  * 3. Killer moves
  * 4. Regular quiet moves
@@ -27,13 +28,19 @@ enum MoveScore : int16_t {
 class MovePicker {
    public:
     /**
-     * @brief Constructs a MovePicker for a specific position and move set
+     * @brief Constructs a MovePicker for the main search
      * @param engine The current engine state with board and search context
-     * @param moves List of legal moves to be picked
      * @param ttMove Transposition table move (if available)
      * @param ply Current ply from root position
      */
-    MovePicker(const Engine& engine, Movelist& moves, Move ttMove, int ply);
+    MovePicker(const Engine& engine, Move ttMove, int ply);
+
+    /**
+     * @brief Constructs a MovePicker for quiescence search (captures only)
+     * @param engine The current engine state with board and search context
+     * @param ttMove Transposition table move (if available)
+     */
+    MovePicker(const Engine& engine, Move ttMove);
 
     /**
      * @brief Returns the next best move according to ordering heuristics
@@ -48,12 +55,14 @@ class MovePicker {
      */
     enum class Phase {
         TT,
-        SCORE,
+        GEN_CAPTURES,
         CAPTURES,
         KILLER1,
         KILLER2,
         COUNTER,
-        QUIET
+        GEN_QUIETS,
+        QUIET,
+        DONE
     };
 
     /**
@@ -64,16 +73,27 @@ class MovePicker {
     int find_best_from(int start_idx);
 
     /**
-     * @brief Checks if a move exists in the current movelist
-     * @param move The move to look for
-     * @return True if the move is in the movelist, false otherwise
+     * @brief Checks if a move is legal in the current position
+     *
+     * Only the moves of the piece type standing on the origin square are
+     * generated, which is much cheaper than a full legal move generation.
+     *
+     * @tparam mt Kind of move the candidate must be (ALL, CAPTURE or QUIET)
+     * @param move The move to check
+     * @return True if the move is legal and of the requested kind
      */
-    bool is_in_movelist(Move move) const;
+    template<movegen::MoveGenType mt>
+    bool is_legal(Move move) const;
 
     /**
-     * @brief Assigns scores to all moves in the movelist for ordering
+     * @brief Assigns MVV-LVA scores to the generated captures
      */
-    void score_moves();
+    void score_captures();
+
+    /**
+     * @brief Assigns history scores to the generated quiet moves
+     */
+    void score_quiets();
 
     /**
      * @brief Calculates the Most Valuable Victim - Least Valuable Attacker score for a capture
@@ -83,7 +103,7 @@ class MovePicker {
     int16_t get_mvvlva_score(const Move& move);
 
     const Engine& engine;
-    Movelist&     movelist;
+    Movelist      movelist;
 
     Move ttmove;
     Move killer1 = Move::NO_MOVE;
@@ -91,6 +111,7 @@ class MovePicker {
     Move counter = Move::NO_MOVE;
 
     int   ply;
+    bool  captures_only;
     Phase phase = Phase::TT;
     int   index = 0;
-};
\ No newline at end of file
+};
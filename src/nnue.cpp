@@ -0,0 +1,229 @@
+#include "nnue.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+    #include <immintrin.h>
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>
+#endif
+
+
+// Read-only once loaded, shared by every search thread
+static std::unique_ptr<nnue::Network> network;
+
+
+/**
+ * @brief Computes the input index of a piece on a square, seen from one perspective
+ *
+ * Pieces of the perspective come first, and the board is mirrored vertically for black,
+ * so that both perspectives see their own pieces moving up the board.
+ */
+static int feature_index(Color perspective, Piece piece, Square sq) {
+    int color_offset = (piece.color() == perspective) ? 0 : 384;
+    int sq_idx       = (perspective == Color::WHITE) ? sq.index() : (sq.index() ^ 56);
+
+    return color_offset + static_cast<int>(piece.type()) * 64 + sq_idx;
+}
+
+
+// SIMD KERNELS
+// Every kernel works on HIDDEN_SIZE int16 values at once, which must be a multiple
+// of the register width (16 lanes for AVX2, 8 for SSE4.1 and NEON).
+
+/**
+ * @brief Adds (or subtracts) a column of feature weights to an accumulator
+ */
+template<bool add>
+static void update_column(int16_t* acc, const int16_t* weights) {
+#if defined(__AVX2__)
+    for (int i = 0; i < nnue::HIDDEN_SIZE; i += 16)
+    {
+        __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc + i));
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+        a         = add ? _mm256_add_epi16(a, w) : _mm256_sub_epi16(a, w);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(acc + i), a);
+    }
+#elif defined(__SSE4_1__)
+    for (int i = 0; i < nnue::HIDDEN_SIZE; i += 8)
+    {
+        __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(acc + i));
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+        a         = add ? _mm_add_epi16(a, w) : _mm_sub_epi16(a, w);
+        _mm_store_si128(reinterpret_cast<__m128i*>(acc + i), a);
+    }
+#elif defined(__ARM_NEON)
+    for (int i = 0; i < nnue::HIDDEN_SIZE; i += 8)
+    {
+        int16x8_t a = vld1q_s16(acc + i);
+        int16x8_t w = vld1q_s16(weights + i);
+        vst1q_s16(acc + i, add ? vaddq_s16(a, w) : vsubq_s16(a, w));
+    }
+#else
+    for (int i = 0; i < nnue::HIDDEN_SIZE; i++)
+        acc[i] += add ? weights[i] : -weights[i];
+#endif
+}
+
+/**
+ * @brief Computes the sum of SCReLU(acc[i]) * weights[i], where SCReLU(x) = clamp(x, 0, QA)^2
+ *
+ * The SIMD versions compute (v * w) * v with v = clamp(x, 0, QA): v * w fits in int16
+ * as long as output weights stay within [-128, 127], and the second product is widened
+ * to int32 by madd, avoiding the overflow of v * v.
+ */
+static int32_t screlu_dot(const int16_t* acc, const int16_t* weights) {
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i qa   = _mm256_set1_epi16(nnue::QA);
+    __m256i       sum  = _mm256_setzero_si256();
+
+    for (int i = 0; i < nnue::HIDDEN_SIZE; i += 16)
+    {
+        __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc + i));
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+        __m256i v = _mm256_min_epi16(_mm256_max_epi16(a, zero), qa);
+        sum       = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_mullo_epi16(v, w), v));
+    }
+
+    __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    sum128         = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum128         = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum128);
+#elif defined(__SSE4_1__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i qa   = _mm_set1_epi16(nnue::QA);
+    __m128i       sum  = _mm_setzero_si128();
+
+    for (int i = 0; i < nnue::HIDDEN_SIZE; i += 8)
+    {
+        __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(acc + i));
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+        __m128i v = _mm_min_epi16(_mm_max_epi16(a, zero), qa);
+        sum       = _mm_add_epi32(sum, _mm_madd_epi16(_mm_mullo_epi16(v, w), v));
+    }
+
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+#elif defined(__ARM_NEON)
+    const int16x8_t zero = vdupq_n_s16(0);
+    const int16x8_t qa   = vdupq_n_s16(nnue::QA);
+    int32x4_t       sum  = vdupq_n_s32(0);
+
+    for (int i = 0; i < nnue::HIDDEN_SIZE; i += 8)
+    {
+        int16x8_t v  = vminq_s16(vmaxq_s16(vld1q_s16(acc + i), zero), qa);
+        int16x8_t vw = vmulq_s16(v, vld1q_s16(weights + i));
+        sum          = vmlal_s16(sum, vget_low_s16(vw), vget_low_s16(v));
+        sum          = vmlal_s16(sum, vget_high_s16(vw), vget_high_s16(v));
+    }
+
+    return vgetq_lane_s32(sum, 0) + vgetq_lane_s32(sum, 1) + vgetq_lane_s32(sum, 2)
+         + vgetq_lane_s32(sum, 3);
+#else
+    int32_t sum = 0;
+
+    for (int i = 0; i < nnue::HIDDEN_SIZE; i++)
+    {
+        int32_t v = std::clamp<int32_t>(acc[i], 0, nnue::QA);
+        sum += v * v * weights[i];
+    }
+
+    return sum;
+#endif
+}
+
+
+bool nnue::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    // bullet pads the file to a multiple of 64 bytes, so only the payload is read
+    constexpr size_t payload = sizeof(Network::feature_weights) + sizeof(Network::feature_bias)
+                             + sizeof(Network::output_weights) + sizeof(Network::output_bias);
+    constexpr size_t padded  = (payload + 63) / 64 * 64;
+
+    // a network of another architecture would be read shifted, reject it by its size
+    std::error_code ec;
+    const size_t    file_size = std::filesystem::file_size(path, ec);
+    if (ec || file_size < payload || file_size > padded)
+        return false;
+
+    auto net = std::make_unique<Network>();
+
+    file.read(reinterpret_cast<char*>(net->feature_weights), sizeof(net->feature_weights));
+    file.read(reinterpret_cast<char*>(net->feature_bias), sizeof(net->feature_bias));
+    file.read(reinterpret_cast<char*>(net->output_weights), sizeof(net->output_weights));
+    file.read(reinterpret_cast<char*>(&net->output_bias), sizeof(net->output_bias));
+
+    if (!file)
+        return false;
+
+    // screlu_dot() multiplies output weights in int16, which only holds for [-128, 127]
+    if (!std::all_of(std::begin(net->output_weights), std::end(net->output_weights),
+                     [](int16_t w) { return w >= -128 && w <= 127; }))
+        return false;
+
+    network = std::move(net);
+    return true;
+}
+
+void nnue::unload() { network.reset(); }
+
+bool nnue::is_loaded() { return network != nullptr; }
+
+const char* nnue::simd_name() {
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE4_1__)
+    return "SSE4.1";
+#elif defined(__ARM_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+void nnue::refresh(Accumulator& acc, const Board& board) {
+    for (Color perspective : {Color::WHITE, Color::BLACK})
+        std::copy(network->feature_bias, network->feature_bias + HIDDEN_SIZE,
+                  acc.values[perspective]);
+
+    Bitboard occupied = board.occ();
+    while (occupied)
+    {
+        Square sq = occupied.pop();
+        add_feature(acc, board.at(sq), sq);
+    }
+}
+
+void nnue::add_feature(Accumulator& acc, Piece piece, Square sq) {
+    for (Color perspective : {Color::WHITE, Color::BLACK})
+    {
+        const int16_t* column =
+          network->feature_weights + feature_index(perspective, piece, sq) * HIDDEN_SIZE;
+        update_column<true>(acc.values[perspective], column);
+    }
+}
+
+void nnue::remove_feature(Accumulator& acc, Piece piece, Square sq) {
+    for (Color perspective : {Color::WHITE, Color::BLACK})
+    {
+        const int16_t* column =
+          network->feature_weights + feature_index(perspective, piece, sq) * HIDDEN_SIZE;
+        update_column<false>(acc.values[perspective], column);
+    }
+}
+
+int nnue::evaluate(const Accumulator& acc, Color stm) {
+    int32_t output = screlu_dot(acc.values[stm], network->output_weights)
+                   + screlu_dot(acc.values[~stm], network->output_weights + HIDDEN_SIZE);
+
+    // SCReLU squares the QA factor, dividing by QA once brings the sum back to QA * QB
+    output = output / QA + network->output_bias;
+    return output * SCALE / (QA * QB);
+}
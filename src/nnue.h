@@ -0,0 +1,101 @@
+#pragma once
+#include "chess.hpp"
+#include <string>
+
+using namespace chess;
+
+/**
+ * Optional NNUE evaluation, replacing the hand-crafted evaluation once a network is loaded.
+ *
+ * Architecture: (768 -> HIDDEN_SIZE) x 2 -> 1, with SCReLU activation.
+ * Each perspective has its own accumulator, the hidden layer of the side to move
+ * being concatenated with the one of the other side before the output layer.
+ *
+ * The network file follows the quantised layout of bullet's simple example:
+ * feature weights, feature biases, output weights and output bias, all int16
+ * and quantised by QA (hidden layer) and QB (output layer).
+ */
+namespace nnue {
+
+constexpr int INPUT_SIZE  = 768;  // 2 colors x 6 piece types x 64 squares
+constexpr int HIDDEN_SIZE = 256;  // Neurons per perspective
+
+constexpr int QA    = 255;  // Hidden layer quantisation
+constexpr int QB    = 64;   // Output layer quantisation
+constexpr int SCALE = 400;  // Conversion from network output to centipawns
+
+/**
+ * @struct Network
+ * @brief Quantised weights and biases of the network
+ */
+struct alignas(64) Network {
+    int16_t feature_weights[INPUT_SIZE * HIDDEN_SIZE];
+    int16_t feature_bias[HIDDEN_SIZE];
+    int16_t output_weights[2 * HIDDEN_SIZE];
+    int16_t output_bias;
+};
+
+/**
+ * @struct Accumulator
+ * @brief Hidden layer pre-activations of both perspectives, indexed by color
+ */
+struct alignas(64) Accumulator {
+    int16_t values[2][HIDDEN_SIZE];
+};
+
+/**
+ * @brief Loads a network from a file
+ * @param path Path of the network file
+ * @return True if the file has the expected size and its output weights fit in [-128, 127]
+ */
+bool load(const std::string& path);
+
+/**
+ * @brief Unloads the current network, falling back to the hand-crafted evaluation
+ */
+void unload();
+
+/**
+ * @brief Checks whether a network is loaded
+ * @return True if NNUE evaluation is in use
+ */
+bool is_loaded();
+
+/**
+ * @brief Name of the SIMD instruction set the inference was compiled for
+ * @return "AVX2", "SSE4.1", "NEON" or "scalar"
+ */
+const char* simd_name();
+
+/**
+ * @brief Recomputes an accumulator from scratch
+ * @param acc Accumulator to compute
+ * @param board Position whose pieces are the active features
+ */
+void refresh(Accumulator& acc, const Board& board);
+
+/**
+ * @brief Activates the feature of a piece on a square, in both perspectives
+ * @param acc Accumulator to update
+ * @param piece Piece placed on the board
+ * @param sq Square of the piece
+ */
+void add_feature(Accumulator& acc, Piece piece, Square sq);
+
+/**
+ * @brief Deactivates the feature of a piece on a square, in both perspectives
+ * @param acc Accumulator to update
+ * @param piece Piece removed from the board
+ * @param sq Square of the piece
+ */
+void remove_feature(Accumulator& acc, Piece piece, Square sq);
+
+/**
+ * @brief Runs the output layer on an up to date accumulator
+ * @param acc Accumulator of the position
+ * @param stm Side to move
+ * @return Evaluation in centipawns from the perspective of the side to move
+ */
+int evaluate(const Accumulator& acc, Color stm);
+
+}  // namespace nnue
@@ -0,0 +1,142 @@
+#include "pawns.h"
+
+static constexpr uint64_t FILE_A_BB = 0x0101010101010101ull;
+static constexpr uint64_t FILE_H_BB = FILE_A_BB << 7;
+
+/**
+ * @brief Extends every bit of a bitboard to all the squares in front of it
+ * @tparam c Color the front is relative to
+ * @param b Bitboard to fill
+ * @return Filled bitboard, including the original bits
+ */
+template<Color::underlying c>
+static uint64_t front_fill(uint64_t b) {
+    if constexpr (c == Color::WHITE)
+    {
+        b |= b << 8;
+        b |= b << 16;
+        b |= b << 32;
+    }
+    else
+    {
+        b |= b >> 8;
+        b |= b >> 16;
+        b |= b >> 32;
+    }
+    return b;
+}
+
+/**
+ * @brief Computes the files adjacent to the bits of a bitboard
+ * @param b Bitboard of squares
+ * @return Every square of the files left and right of the given squares
+ */
+static uint64_t adjacent_files(uint64_t b) {
+    uint64_t files = front_fill<Color::WHITE>(b) | front_fill<Color::BLACK>(b);
+    return ((files & ~FILE_A_BB) >> 1) | ((files & ~FILE_H_BB) << 1);
+}
+
+template<Color::underlying c>
+static uint64_t pawn_attacks(uint64_t pawns) {
+    return (attacks::pawnLeftAttacks<c>(pawns) | attacks::pawnRightAttacks<c>(pawns)).getBits();
+}
+
+template<Color::underlying c>
+static void evaluate_pawns(const Board& board, PawnEntry& entry) {
+    constexpr int us   = static_cast<int>(c);
+    constexpr int them = us ^ 1;
+    constexpr int sign = c == Color::WHITE ? 1 : -1;
+
+    const uint64_t ours   = board.pieces(PieceType::PAWN, Color(c)).getBits();
+    const uint64_t theirs = board.pieces(PieceType::PAWN, ~Color(c)).getBits();
+
+    // the attacks and spans of both sides are filled in beforehand by evaluate_pawns()
+    const uint64_t our_span      = entry.attack_span[us].getBits();
+    const uint64_t their_attacks = entry.attacks[them].getBits();
+
+    uint64_t passed = 0;
+    uint64_t pawns  = ours;
+
+    while (pawns)
+    {
+        const int      sq    = __builtin_ctzll(pawns);
+        const uint64_t bb    = 1ull << sq;
+        const uint64_t stop  = c == Color::WHITE ? bb << 8 : bb >> 8;
+        const uint64_t front = front_fill<c>(stop);
+        const uint64_t span  = front | ((front & ~FILE_A_BB) >> 1) | ((front & ~FILE_H_BB) << 1);
+        const int      rank  = c == Color::WHITE ? sq / 8 : 7 - sq / 8;
+
+        pawns &= pawns - 1;
+
+        const bool doubled  = front & ours;
+        const bool isolated = !(adjacent_files(bb) & ours);
+        const bool backward = !isolated && !(stop & our_span) && (stop & their_attacks);
+
+        // passed: no enemy pawn ahead on its own or the adjacent files
+        if (!doubled && !(span & theirs))
+        {
+            passed |= bb;
+            entry.mg_score += sign * eval::passed_pawn_mg[rank];
+            entry.eg_score += sign * eval::passed_pawn_eg[rank];
+        }
+
+        if (doubled)
+        {
+            entry.mg_score -= sign * eval::doubled_pawn_mg;
+            entry.eg_score -= sign * eval::doubled_pawn_eg;
+        }
+
+        if (isolated)
+        {
+            entry.mg_score -= sign * eval::isolated_pawn_mg;
+            entry.eg_score -= sign * eval::isolated_pawn_eg;
+        }
+
+        else if (backward)
+        {
+            entry.mg_score -= sign * eval::backward_pawn_mg;
+            entry.eg_score -= sign * eval::backward_pawn_eg;
+        }
+    }
+
+    entry.passed[us] = passed;
+}
+
+void evaluate_pawns(const Board& board, PawnEntry& entry) {
+    const uint64_t white = board.pieces(PieceType::PAWN, Color::WHITE).getBits();
+    const uint64_t black = board.pieces(PieceType::PAWN, Color::BLACK).getBits();
+
+    const uint64_t white_attacks = pawn_attacks<Color::WHITE>(white);
+    const uint64_t black_attacks = pawn_attacks<Color::BLACK>(black);
+
+    entry.mg_score       = 0;
+    entry.eg_score       = 0;
+    entry.attacks[0]     = white_attacks;
+    entry.attacks[1]     = black_attacks;
+    entry.attack_span[0] = front_fill<Color::WHITE>(white_attacks);
+    entry.attack_span[1] = front_fill<Color::BLACK>(black_attacks);
+
+    evaluate_pawns<Color::WHITE>(board, entry);
+    evaluate_pawns<Color::BLACK>(board, entry);
+}
+
+PawnTable::PawnTable() :
+    entries(SIZE) {}
+
+const PawnEntry& PawnTable::probe(const Position& pos) {
+    const uint64_t key   = pos.pawn_key();
+    PawnEntry&     entry = entries[key & (SIZE - 1)];
+
+    probes++;
+
+    // entries start zeroed, which is also the evaluation of the pawnless key 0
+    if (entry.key == key)
+    {
+        hits++;
+        return entry;
+    }
+
+    entry.key = key;
+    evaluate_pawns(pos, entry);
+    return entry;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "chess.hpp"
+#include "position.h"
+#include <vector>
+
+using namespace chess;
+
+/**
+ * @struct PawnEntry
+ * @brief Cached evaluation of a pawn structure
+ * 
+ * The pawn structure changes on few moves only, so its evaluation is computed once
+ * per pawn key and shared by every position with the same pawns. Besides the scores,
+ * it keeps the bitboards other evaluation terms need, indexed by color.
+ */
+struct PawnEntry {
+    uint64_t key      = 0;
+    int      mg_score = 0;  // from white's perspective
+    int      eg_score = 0;  // from white's perspective
+
+    Bitboard passed[2];       // passed pawns
+    Bitboard attacks[2];      // squares attacked by pawns
+    Bitboard attack_span[2];  // squares pawns attack now or could attack after advancing
+};
+
+/**
+ * @class PawnTable
+ * @brief Per-thread hash table caching pawn structure evaluations
+ * 
+ * Indexed by the pawn-only Zobrist key of the position, an entry is simply
+ * recomputed and overwritten on a miss.
+ */
+class PawnTable {
+   public:
+    /**
+     * @brief Allocates an empty pawn table
+     */
+    PawnTable();
+
+    /**
+     * @brief Looks up the pawn structure of a position, evaluating it on a miss
+     * @param pos Current board position
+     * @return Entry holding the pawn structure evaluation of the position
+     */
+    const PawnEntry& probe(const Position& pos);
+
+    /**
+     * @brief Returns the share of probes answered by the table
+     * @return Hit rate in percent since the table was created
+     */
+    double hit_rate() const { return probes ? 100.0 * hits / probes : 0.0; }
+
+    // Number of entries, a power of two
+    static constexpr size_t SIZE = 16384;
+
+   private:
+    std::vector<PawnEntry> entries;
+    uint64_t               hits   = 0;
+    uint64_t               probes = 0;
+};
+
+/**
+ * @brief Evaluates the pawn structure of a position from scratch
+ * 
+ * Scores passed, isolated, doubled and backward pawns.
+ * 
+ * @param board Current board position
+ * @param entry Entry receiving the scores and pawn bitboards
+ */
+void evaluate_pawns(const Board& board, PawnEntry& entry);
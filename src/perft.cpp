@@ -1,29 +1,101 @@
 #include "perft.h"
+#include <memory>
+#include <thread>
 
-std::uint64_t perft(Board& board, int depth) {
+PerftHash::PerftHash(size_t size_mib)
+    : entries(std::max<size_t>(1, size_mib * 1024 * 1024 / sizeof(Entry))) {}
+
+bool PerftHash::probe(uint64_t key, int depth, uint64_t& nodes) const {
+    const Entry&   entry = entries[key % entries.size()];
+    const uint64_t data  = entry.data.load(std::memory_order_relaxed);
+    const uint64_t check = entry.check.load(std::memory_order_relaxed);
+
+    if ((check ^ data) != key || int(data & 0xFF) != depth)
+        return false;
+
+    nodes = data >> 8;
+    return true;
+}
+
+void PerftHash::store(uint64_t key, int depth, uint64_t nodes) {
+    Entry&         entry = entries[key % entries.size()];
+    const uint64_t data  = nodes << 8 | uint64_t(depth);
+    entry.check.store(key ^ data, std::memory_order_relaxed);
+    entry.data.store(data, std::memory_order_relaxed);
+}
+
+std::uint64_t perft(Board& board, int depth, PerftHash* hash) {
     Movelist moves;
     movegen::legalmoves(moves, board);
 
-    if (depth == 1)
-        return moves.size();
+    if (depth <= 1)
+        return depth == 1 ? moves.size() : 1;
 
     uint64_t nodes = 0;
 
+    if (hash && hash->probe(board.hash(), depth, nodes))
+        return nodes;
+
     for (int i = 0; i < moves.size(); i++)
     {
         const auto move = moves[i];
         board.makeMove(move);
-        nodes += perft(board, depth - 1);
+        nodes += perft(board, depth - 1, hash);
         board.unmakeMove(move);
     }
 
+    if (hash)
+        hash->store(board.hash(), depth, nodes);
+
     return nodes;
 }
 
-uint64_t start_perft(const std::string& fen, int depth) {
-    Board    board   = Board::fromFen(fen);
-    auto     t0      = std::chrono::high_resolution_clock::now();
-    uint64_t nodes   = perft(board, depth);
+uint64_t start_perft(const std::string& fen, int depth, int threads, size_t hash_mib) {
+    Board    root = Board::fromFen(fen);
+    Movelist moves;
+    movegen::legalmoves(moves, root);
+
+    // the root itself is the only leaf, there are no moves to divide
+    if (depth <= 0)
+    {
+        std::cout << "\ntime: 0ms" << std::endl;
+        std::cout << "Nodes:1 nps 0" << std::endl;
+        return 1;
+    }
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    std::unique_ptr<PerftHash> hash;
+    if (hash_mib > 0)
+        hash = std::make_unique<PerftHash>(hash_mib);
+
+    // ROOT SPLIT
+    // each thread takes the next unclaimed root move until none are left
+    std::vector<uint64_t>    divide(moves.size(), 0);
+    std::atomic<int>         next{0};
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < std::max(1, threads); t++)
+        workers.emplace_back([&]() {
+            Board board = root;
+            for (int i = next++; i < moves.size(); i = next++)
+            {
+                board.makeMove(moves[i]);
+                divide[i] = perft(board, depth - 1, hash.get());
+                board.unmakeMove(moves[i]);
+            }
+        });
+
+    for (auto& worker : workers)
+        worker.join();
+
+    uint64_t nodes = 0;
+    for (int i = 0; i < moves.size(); i++)
+    {
+        std::cout << uci::moveToUci(moves[i]) << ": " << divide[i] << "\n";
+        nodes += divide[i];
+    }
+
     auto     t1      = std::chrono::high_resolution_clock::now();
     auto     elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
     uint64_t nps     = (nodes * 1000) / (elapsed + 1);
@@ -31,4 +103,4 @@ uint64_t start_perft(const std::string& fen, int depth) {
     std::cout << "Nodes:" << nodes << " nps " << nps << std::endl;
 
     return nodes;
-}
\ No newline at end of file
+}
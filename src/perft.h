@@ -1,23 +1,75 @@
 #pragma once
 #include "chess.hpp"
+#include <atomic>
 #include <chrono>
+#include <vector>
 
 using namespace chess;
 
+/**
+ * @class PerftHash
+ * @brief Lockless table of (key, depth) -> leaf count, shared by the perft threads
+ * 
+ * Each entry stores the count with its depth and the position key XORed with that data,
+ * so that an entry torn by a concurrent write fails the key check instead of returning
+ * a wrong count.
+ */
+class PerftHash {
+   public:
+    /**
+     * @brief Allocates the table
+     * @param size_mib Size of the table in MiB
+     */
+    explicit PerftHash(size_t size_mib);
+
+    /**
+     * @brief Looks up the leaf count of a position
+     * @param key Zobrist key of the position
+     * @param depth Remaining depth
+     * @param nodes Set to the stored count on a hit
+     * @return True if the position was found at this depth
+     */
+    bool probe(uint64_t key, int depth, uint64_t& nodes) const;
+
+    /**
+     * @brief Stores the leaf count of a position, always replacing the previous entry
+     * @param key Zobrist key of the position
+     * @param depth Remaining depth
+     * @param nodes Leaf count of the position
+     */
+    void store(uint64_t key, int depth, uint64_t nodes);
+
+   private:
+    struct Entry {
+        std::atomic<uint64_t> check{0};  // key ^ data
+        std::atomic<uint64_t> data{0};   // nodes << 8 | depth
+    };
+
+    std::vector<Entry> entries;
+};
+
 /**
  * @brief Recursively counts all legal moves to a given depth
  * 
+ * Moves at the last ply are bulk counted instead of being made.
+ * 
  * @param board Current board position
  * @param depth Remaining depth to search
+ * @param hash Optional table of already counted subtrees
  * @return Number of leaf nodes at the specified depth
  */
-uint64_t perft(Board& board, int depth);
+uint64_t perft(Board& board, int depth, PerftHash* hash = nullptr);
 
 /**
  * @brief Initializes and runs a perft test from a given position
  * 
+ * The root moves are shared out to the threads, and the leaf count of each of them
+ * is printed in divide format.
+ * 
  * @param fen FEN string representing the starting position
- * @param depth Maximum depth to search
+ * @param depth Maximum depth to search, the root alone being counted at depth 0 or less
+ * @param threads Number of threads
+ * @param hash_mib Size of the perft hash in MiB, 0 to disable it
  * @return The total count of leaf nodes generated at the specified depth.
  */
-uint64_t start_perft(const std::string& fen, int depth);
\ No newline at end of file
+uint64_t start_perft(const std::string& fen, int depth, int threads = 1, size_t hash_mib = 0);
@@ -0,0 +1,125 @@
+#include "position.h"
+#include "evaluate.h"
+
+
+Position::Position(std::string_view fen) :
+    Board(fen) {
+    // the Board constructor bypasses the placement hooks
+    refresh();
+}
+
+bool Position::setFen(std::string_view fen) {
+    bool valid = Board::setFen(fen);
+    refresh();
+    return valid;
+}
+
+void Position::refresh() {
+    mg    = 0;
+    eg    = 0;
+    phase = 0;
+    calculate_material_score(*this, mg, eg, phase);
+
+    materialkey       = 0;
+    Bitboard occupied = occ();
+    while (occupied)
+        materialkey += 1ull << (4 * at(occupied.pop()));
+
+    pawnkey = 0;
+    for (Color color : {Color::WHITE, Color::BLACK})
+    {
+        Bitboard pawns = pieces(PieceType::PAWN, color);
+        while (pawns)
+            pawnkey ^= zobrist_keys.piece[Piece(PieceType::PAWN, color)][pawns.pop()];
+    }
+
+    acc_idx      = 0;
+    acc_overflow = 0;
+
+    if (!nnue::is_loaded())
+    {
+        accumulators.clear();
+        return;
+    }
+
+    accumulators.resize(ACC_STACK_SIZE);
+    nnue::refresh(accumulators[0], *this);
+}
+
+void Position::makeMove(Move move) {
+    if (nnue_enabled())
+    {
+        if (acc_idx + 1 < ACC_STACK_SIZE)
+        {
+            accumulators[acc_idx + 1] = accumulators[acc_idx];
+            acc_idx++;
+        }
+        else
+            acc_overflow++;
+    }
+
+    Board::makeMove(move);
+}
+
+void Position::unmakeMove(Move move) {
+    if (!nnue_enabled() || acc_overflow > 0)
+    {
+        // the hooks revert the in place updates
+        acc_overflow -= nnue_enabled();
+        Board::unmakeMove(move);
+        return;
+    }
+
+    if (acc_idx == 0)
+    {
+        // unmaking a move played before the last refresh
+        Board::unmakeMove(move);
+        refresh();
+        return;
+    }
+
+    acc_frozen = true;
+    Board::unmakeMove(move);
+    acc_frozen = false;
+    acc_idx--;
+}
+
+void Position::placePiece(Piece piece, Square sq) {
+    Board::placePiece(piece, sq);
+
+    int pt     = static_cast<int>(piece.type());
+    int sign   = (piece.color() == Color::WHITE) ? 1 : -1;
+    int sq_idx = (piece.color() == Color::BLACK) ? (sq.index() ^ 56) : sq.index();
+
+    mg += sign * pst::mg_table[pt][sq_idx];
+    eg += sign * pst::eg_table[pt][sq_idx];
+    phase += pst::game_phase_inc[pt];
+
+    if (piece.type() == PieceType::PAWN)
+        pawnkey ^= zobrist_keys.piece[piece][sq.index()];
+
+    materialkey += 1ull << (4 * piece);
+
+    if (nnue_enabled() && !acc_frozen)
+        nnue::add_feature(accumulators[acc_idx], piece, sq);
+}
+
+void Position::removePiece(Piece piece, Square sq) {
+    Board::removePiece(piece, sq);
+
+    int pt     = static_cast<int>(piece.type());
+    int sign   = (piece.color() == Color::WHITE) ? 1 : -1;
+    int sq_idx = (piece.color() == Color::BLACK) ? (sq.index() ^ 56) : sq.index();
+
+    mg -= sign * pst::mg_table[pt][sq_idx];
+    eg -= sign * pst::eg_table[pt][sq_idx];
+    phase -= pst::game_phase_inc[pt];
+
+    if (piece.type() == PieceType::PAWN)
+        pawnkey ^= zobrist_keys.piece[piece][sq.index()];
+
+    materialkey -= 1ull << (4 * piece);
+
+    if (nnue_enabled() && !acc_frozen)
+        nnue::remove_feature(accumulators[acc_idx], piece, sq);
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include "chess.hpp"
+#include "arrays.h"
+#include "hash.h"
+#include "nnue.h"
+#include "types.h"
+#include <vector>
+
+using namespace chess;
+
+/**
+ * @class Position
+ * @brief Board keeping its material and piece-square table scores up to date
+ * 
+ * Overrides the piece placement hooks of the chess library's Board, so that
+ * makeMove() and unmakeMove() update the middlegame and endgame scores and the
+ * game phase as pieces move. The evaluation then reads them in O(1) instead of
+ * walking every piece of the board.
+ * 
+ * The Zobrist key of the pawns alone is maintained the same way, to index the pawn
+ * hash table, and so is the material key, to index the material table.
+ * 
+ * When a network is loaded, it also keeps a stack of NNUE accumulators: makeMove()
+ * pushes a copy of the current accumulator and updates it through the same hooks,
+ * unmakeMove() simply pops it.
+ */
+class Position : public Board {
+   public:
+    /**
+     * @brief Constructs a position from a FEN string
+     * @param fen FEN string of the position, the starting position by default
+     */
+    explicit Position(std::string_view fen = constants::STARTPOS);
+
+    /**
+     * @brief Sets the position from a FEN string and recomputes its scores
+     * @param fen FEN string of the position
+     * @return True if the FEN was successfully parsed
+     */
+    bool setFen(std::string_view fen) override;
+
+    /**
+     * @brief Recomputes the scores, game phase and NNUE accumulator from scratch
+     * 
+     * Also empties the accumulator stack, leaving its whole depth to the next search.
+     */
+    void refresh();
+
+    /**
+     * @brief Makes a move, pushing the NNUE accumulator first
+     * @param move Legal move to make
+     */
+    void makeMove(Move move);
+
+    /**
+     * @brief Unmakes a move, popping the NNUE accumulator
+     * @param move Last move made
+     */
+    void unmakeMove(Move move);
+
+    /**
+     * @brief Checks whether the position maintains NNUE accumulators
+     * @return True if a network was loaded when the position was last refreshed
+     */
+    bool nnue_enabled() const { return !accumulators.empty(); }
+
+    /**
+     * @brief Returns the accumulator of the current position
+     * @return Up to date NNUE accumulator, only valid if nnue_enabled()
+     */
+    const nnue::Accumulator& accumulator() const { return accumulators[acc_idx]; }
+
+    // Incrementally updated scores, from white's perspective
+    int mg_score() const { return mg; }
+    int eg_score() const { return eg; }
+
+    // Incrementally updated game phase, not capped to 24 (promotions can exceed it)
+    int game_phase() const { return phase; }
+
+    // Incrementally updated Zobrist key of the pawns of both sides
+    uint64_t pawn_key() const { return pawnkey; }
+
+    // Incrementally updated material signature, the count of each piece in 4 bits
+    uint64_t material_key() const { return materialkey; }
+
+   protected:
+    /**
+     * @brief Places a piece on the board and adds its contribution to the scores
+     * @param piece Piece to place
+     * @param sq Square to place the piece on
+     */
+    void placePiece(Piece piece, Square sq) override;
+
+    /**
+     * @brief Removes a piece from the board and subtracts its contribution from the scores
+     * @param piece Piece to remove
+     * @param sq Square to remove the piece from
+     */
+    void removePiece(Piece piece, Square sq) override;
+
+   private:
+    // Enough for a full search from the root, deeper moves update the top accumulator in place
+    static constexpr int ACC_STACK_SIZE = MAX_PLY + 8;
+
+    int      mg      = 0;
+    int      eg      = 0;
+    int      phase   = 0;
+    uint64_t pawnkey = 0;
+
+    uint64_t materialkey = 0;
+
+    // NNUE accumulator stack, empty when no network is loaded
+    std::vector<nnue::Accumulator> accumulators;
+    // Index of the accumulator of the current position
+    int acc_idx = 0;
+    // Moves made while the stack was full, whose updates were applied in place
+    int acc_overflow = 0;
+    // Set while unmaking a move, when the popped accumulator must not be updated
+    bool acc_frozen = false;
+};
@@ -8,16 +8,47 @@
 using namespace chess;
 
 
-Move Engine::get_bestmove(int depth) { return iterative_deepening(depth); }
+Move Engine::get_bestmove(int depth) {
+    starttime = std::chrono::high_resolution_clock::now();
+    tt->new_search();
+
+    // LAZY SMP
+    // Helpers search the same root concurrently, sharing results through the TT
+    start_helpers(depth);
+    Move bestmove = iterative_deepening(depth);
+
+    // GO INFINITE
+    // The bestmove must not be sent before the GUI asks the search to stop
+    while (limits.isInfinite && !stop_search)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    stop_helpers();
+
+    // a search stopped before completing depth 1 still owes the GUI a legal move
+    if (bestmove == Move::NO_MOVE)
+    {
+        Movelist moves;
+        movegen::legalmoves(moves, board);
+        if (moves.size() > 0)
+            bestmove = moves[0];
+    }
+
+    return bestmove;
+}
 
 Move Engine::iterative_deepening(int max_depth) {
     // SEARCH INITIALIZATION
-    starttime     = std::chrono::high_resolution_clock::now();
-    stop_search   = false;
-    nodes         = 0;
-    int  score    = -VALUE_INF;
-    Move bestmove = Move::NO_MOVE;
+    nodes           = 0;
+    tt_probes       = 0;
+    tt_hits         = 0;
+    completed_depth = 0;
+    int  score      = -VALUE_INF;
+    Move bestmove   = Move::NO_MOVE;
     init_tables();
+    stats.clear();
+
+    // reset the NNUE accumulator stack, so that its whole depth is available
+    board.refresh();
 
     // STACK INITIALIZATION
     Stack  stack[MAX_PLY + 4] = {};
@@ -28,6 +59,10 @@ Move Engine::iterative_deepening(int max_depth) {
     // ITERATIVE DEEPENING LOOP
     for (int depth = 1; depth <= max_depth; depth++)
     {
+        // LAZY SMP DEPTH STAGGERING
+        if (skip_depth(depth))
+            continue;
+
         int prevscore = score;
         score         = aspiration_window_search(depth, prevscore, ss);
         bestmove      = pv_table[0][0];
@@ -38,8 +73,10 @@ Move Engine::iterative_deepening(int max_depth) {
             // we print pv for the latest fully searched depth
             break;
 
+        completed_depth = depth;
+
         // SEARCH INFO OUTPUT
-        print_search_info(depth, score, nodes, get_elapsedtime());
+        print_search_info(depth, score, get_total_nodes(), get_elapsedtime());
     }
 
     return bestmove;
@@ -148,30 +185,45 @@ int Engine::negamax_search(int alpha, int beta, int depth, Stack* ss) {
     if (depth <= 0)
         return quiescence_search<node>(alpha, beta, ss);
 
+    stats.bump(STAT_NODES);
+
     // TRANSPOSITION TABLE PROBE
-    Move     ttmove  = Move::NO_MOVE;
-    bool     tthit   = false;
-    TTEntry* tte     = tt.probe(board.hash(), ttmove, tthit);
-    int      ttscore = tthit ? tte->score : VALUE_NONE;
+    Move    ttmove  = Move::NO_MOVE;
+    bool    tthit   = false;
+    TTEntry tte     = tt->probe(board.hash(), ttmove, tthit);
+    int     ttscore = tthit ? tte.score() : VALUE_NONE;
+    tt_probes++;
+    tt_hits += tthit;
 
     // avoid cutting off the root node
     if (is_root_node)
         goto moveloop;
 
     // TRANSPOSITION TABLE CUTOFF
-    if (is_cut_node && tthit && ttscore != VALUE_NONE && tte->depth >= depth)
+    if (is_cut_node && tthit && ttscore != VALUE_NONE && tte.depth() >= depth)
     {
-        if (tte->bound == BOUND_EXACT)
-            return ttscore;
-
-        else if (tte->bound == BOUND_LOWER)
+        if (tte.bound() == BOUND_LOWER)
             alpha = std::max(alpha, ttscore);
 
-        else if (tte->bound == BOUND_UPPER)
+        else if (tte.bound() == BOUND_UPPER)
             beta = std::min(beta, ttscore);
 
-        if (alpha >= beta)
+        if (tte.bound() == BOUND_EXACT || alpha >= beta)
+        {
+            stats.bump(STAT_TT_CUTOFFS);
             return ttscore;
+        }
+    }
+
+    // KPK BITBASE
+    // a drawn king and pawn ending is exact, but a won one only bounds the score: the
+    // search goes on unless it is outside the window, so that the pawn gets promoted
+    if (board.occ().count() == 3 && board.pieces(PieceType::PAWN))
+    {
+        const int kpk_eval = evaluate(board, eval_tables, eval_cache);
+
+        if (kpk_eval == 0 || (kpk_eval > 0 ? kpk_eval >= beta : kpk_eval <= alpha))
+            return kpk_eval;
     }
 
     // INTERNAL ITERATIVE REDUCTIONS (IIR)
@@ -190,7 +242,7 @@ int Engine::negamax_search(int alpha, int beta, int depth, Stack* ss) {
     }
 
     // STATIC BOARD EVALUATION
-    ss->eval = tthit ? ttscore : evaluate(board);
+    ss->eval = tthit ? ttscore : evaluate(board, eval_tables, eval_cache);
 
     if (ss->ply > 2)
         improving = (ss - 2)->eval != VALUE_NONE && (ss - 2)->eval < ss->eval;
@@ -201,7 +253,10 @@ int Engine::negamax_search(int alpha, int beta, int depth, Stack* ss) {
 
     // RAZORING
     if (depth < 3 && ss->eval + 150 < alpha)
+    {
+        stats.bump(STAT_RAZORING);
         return quiescence_search<CUT>(alpha, beta, ss);
+    }
 
     // REVERSE FUTILITY PRUNING (RFP)
     if (ttmove != Move::NO_MOVE && !board.isCapture(ttmove))
@@ -209,19 +264,26 @@ int Engine::negamax_search(int alpha, int beta, int depth, Stack* ss) {
         const int margin = 150 * depth;
 
         if (ss->eval >= beta + margin)
+        {
+            stats.bump(STAT_RFP);
             return ss->eval;
+        }
     }
 
     // NULL MOVE PRUNING (NMP)
     if (depth >= 3 && ss->eval >= beta && ss->currmove != Move::NO_MOVE)
     {
         const int reduction = 5 + std::min(4, depth / 5) + std::min(3, (ss->eval - beta) / 200);
+        stats.bump(STAT_NMP_TRIES);
         board.makeNullMove();
         int nullmove_score = -negamax_search<CUT>(-beta, -beta + 1, depth - reduction, ss + 1);
         board.unmakeNullMove();
 
         if (nullmove_score >= beta)
+        {
+            stats.bump(STAT_NMP_CUTOFFS);
             return nullmove_score >= VALUE_MATE_IN_PLY ? beta : nullmove_score;
+        }
     }
 
 moveloop:
@@ -234,10 +296,7 @@ moveloop:
     Move move       = Move::NO_MOVE;
 
     // MOVE GENERATION AND ORDERING
-    Movelist moves;
-    movegen::legalmoves(moves, board);
-
-    MovePicker mp(*this, moves, ttmove, ss->ply);
+    MovePicker mp(*this, ttmove, ss->ply);
     while ((move = mp.next_move()) != Move::NO_MOVE)
     {
         // MOVE CLASSIFICATION
@@ -260,7 +319,10 @@ moveloop:
             {
                 // LATE MOVE PRUNING (LMP)
                 if (!is_in_check && is_cut_node && depth <= 5 && quietcount > (4 + depth * depth))
+                {
+                    stats.bump(STAT_LMP);
                     continue;
+                }
             }
         }
 
@@ -284,7 +346,8 @@ moveloop:
         //     }
         // }
 
-        nodes++;
+        count_node();
+        tt->prefetch(key_after(board, move));
         board.makeMove(move);
         ss->currmove = move;
 
@@ -309,6 +372,10 @@ moveloop:
             // Only do null window search at full depth if the reduced search beats alpha
             // and we actually reduced the depth (to avoid doing the same search twice)
             do_null_window_search_at_full_depth = score > alpha && reduced_depth < new_depth;
+
+            stats.bump(STAT_LMR_SEARCHES);
+            if (do_null_window_search_at_full_depth)
+                stats.bump(STAT_LMR_RESEARCHES);
         }
         else
             do_null_window_search_at_full_depth = is_cut_node || movecount > 1;
@@ -352,6 +419,10 @@ moveloop:
         // BETA CUTOFF
         if (score >= beta)
         {
+            stats.bump(STAT_BETA_CUTOFFS);
+            if (movecount == 1)
+                stats.bump(STAT_FIRST_MOVE_CUTOFFS);
+
             // KILLER & HISTORY UPDATES
             if (!is_capture)
                 update_quiet_heuristics(move, ss->ply, depth);
@@ -368,7 +439,7 @@ moveloop:
     const Bound bound = bestscore >= beta                         ? BOUND_LOWER
                       : (is_pv_node && bestmove != Move::NO_MOVE) ? BOUND_EXACT
                                                                   : BOUND_UPPER;
-    tt.store(board.hash(), depth, bestscore, bestmove, bound);
+    tt->store(board.hash(), depth, bestscore, bestmove, bound);
 
     return bestscore;
 }
@@ -381,7 +452,9 @@ int Engine::quiescence_search(int alpha, int beta, Stack* ss) {
 
     // MAX DEPTH CHECK
     if (ss->ply >= MAX_PLY)
-        return evaluate(board);
+        return evaluate(board, eval_tables, eval_cache);
+
+    stats.bump(STAT_QNODES);
 
     // NODE CLASSIFICATION
     constexpr bool is_cut_node = (node == CUT);
@@ -392,24 +465,26 @@ int Engine::quiescence_search(int alpha, int beta, Stack* ss) {
         return -1 + (nodes & 0x2);
 
     // TRANSPOSITION TABLE PROBE
-    Move     ttmove  = Move::NO_MOVE;
-    bool     tthit   = false;
-    TTEntry* tte     = tt.probe(board.hash(), ttmove, tthit);
-    int      ttscore = tthit ? tte->score : VALUE_NONE;
+    Move    ttmove  = Move::NO_MOVE;
+    bool    tthit   = false;
+    TTEntry tte     = tt->probe(board.hash(), ttmove, tthit);
+    int     ttscore = tthit ? tte.score() : VALUE_NONE;
+    tt_probes++;
+    tt_hits += tthit;
 
     // TRANSPOSITION TABLE CUTOFF
     // clang-format off
     if (tthit
     &&  is_cut_node
     &&  ttscore != VALUE_NONE
-    &&   ((tte->bound == BOUND_EXACT)
-       || (tte->bound == BOUND_LOWER && ttscore >= beta)
-       || (tte->bound == BOUND_UPPER && ttscore <= alpha)))
+    &&   ((tte.bound() == BOUND_EXACT)
+       || (tte.bound() == BOUND_LOWER && ttscore >= beta)
+       || (tte.bound() == BOUND_UPPER && ttscore <= alpha)))
         return ttscore;
     // clang-format on
 
     // STAND PAT EVALUATION
-    int bestscore = evaluate(board);
+    int bestscore = evaluate(board, eval_tables, eval_cache);
 
     if (bestscore >= beta)
         return bestscore;
@@ -423,17 +498,15 @@ int Engine::quiescence_search(int alpha, int beta, Stack* ss) {
     Move move     = Move::NO_MOVE;
 
     // MOVE GENERATION AND ORDERING
-    Movelist moves;
-    movegen::legalmoves<movegen::MoveGenType::CAPTURE>(moves, board);
-
-    MovePicker mp(*this, moves, ttmove, ss->ply);
+    MovePicker mp(*this, ttmove);
     while ((move = mp.next_move()) != Move::NO_MOVE)
     {
         // STATIC EXCHANGE EVALUATION (SEE) PRUNING
         if (!board.inCheck() && !SEE(board, move, 1))
             continue;
 
-        nodes++;
+        count_node();
+        tt->prefetch(key_after(board, move));
         board.makeMove(move);
         score = -quiescence_search<node>(-beta, -alpha, ss + 1);
         board.unmakeMove(move);
@@ -463,7 +536,7 @@ int Engine::quiescence_search(int alpha, int beta, Stack* ss) {
 
     // TRANSPOSITION TABLE STORE
     Bound bound = bestscore >= beta ? BOUND_LOWER : BOUND_UPPER;
-    tt.store(board.hash(), DEPTH_QS, bestscore, bestmove, bound);
+    tt->store(board.hash(), DEPTH_QS, bestscore, bestmove, bound);
 
     return bestscore;
 }
\ No newline at end of file
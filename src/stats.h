@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+
+// Search statistics are compiled in with make STATS=1, and cost nothing otherwise
+#ifndef SEARCH_STATS
+    #define SEARCH_STATS 0
+#endif
+
+/**
+ * @enum StatCounter
+ * @brief Events counted by the search when statistics are enabled
+ */
+enum StatCounter {
+    STAT_NODES,               ///< Main search nodes, quiescence excluded
+    STAT_QNODES,              ///< Quiescence search nodes
+    STAT_TT_CUTOFFS,          ///< Main search nodes cut off by a TT entry
+    STAT_RAZORING,            ///< Nodes dropped into quiescence by razoring
+    STAT_RFP,                 ///< Nodes pruned by reverse futility pruning
+    STAT_NMP_TRIES,           ///< Null move searches
+    STAT_NMP_CUTOFFS,         ///< Null move searches failing high
+    STAT_LMP,                 ///< Quiet moves skipped by late move pruning
+    STAT_LMR_SEARCHES,        ///< Reduced searches
+    STAT_LMR_RESEARCHES,      ///< Reduced searches beating alpha, searched again at full depth
+    STAT_BETA_CUTOFFS,        ///< Nodes failing high in the move loop
+    STAT_FIRST_MOVE_CUTOFFS,  ///< Nodes failing high on their first move
+    STAT_COUNT
+};
+
+/**
+ * @struct SearchStatsT
+ * @brief Per-thread search counters, empty when statistics are disabled
+ *
+ * The disabled specialisation has no data and no-op member functions, so that
+ * the counting sites of the search compile to nothing.
+ *
+ * @tparam enabled Whether the counters exist
+ */
+template<bool enabled>
+struct SearchStatsT {
+    void bump(StatCounter) {}
+    void clear() {}
+    void add(const SearchStatsT&) {}
+    void print() const {
+        std::cout << "info string search stats are disabled, rebuild with make STATS=1"
+                  << std::endl;
+    }
+};
+
+template<>
+struct SearchStatsT<true> {
+    uint64_t counters[STAT_COUNT] = {};
+
+    /**
+     * @brief Counts one occurrence of an event
+     * @param counter Event to count
+     */
+    void bump(StatCounter counter) { counters[counter]++; }
+
+    /**
+     * @brief Resets every counter to zero
+     */
+    void clear() {
+        for (auto& counter : counters)
+            counter = 0;
+    }
+
+    /**
+     * @brief Adds the counters of another thread or search
+     * @param other Counters to add
+     */
+    void add(const SearchStatsT& other) {
+        for (int i = 0; i < STAT_COUNT; i++)
+            counters[i] += other.counters[i];
+    }
+
+    /**
+     * @brief Prints the counters, with each one as a share of the nodes it applies to
+     */
+    void print() const {
+        auto pct = [](uint64_t part, uint64_t whole) {
+            return whole ? 100.0 * part / whole : 0.0;
+        };
+
+        const uint64_t nodes = counters[STAT_NODES];
+        const uint64_t total = nodes + counters[STAT_QNODES];
+
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "info string search stats\n";
+        std::cout << "main nodes            " << nodes << "\n";
+        std::cout << "qsearch nodes         " << counters[STAT_QNODES] << " ("
+                  << pct(counters[STAT_QNODES], total) << "% of all nodes)\n";
+        std::cout << "tt cutoffs            " << counters[STAT_TT_CUTOFFS] << " ("
+                  << pct(counters[STAT_TT_CUTOFFS], nodes) << "% of main nodes)\n";
+        std::cout << "razoring              " << counters[STAT_RAZORING] << " ("
+                  << pct(counters[STAT_RAZORING], nodes) << "% of main nodes)\n";
+        std::cout << "reverse futility      " << counters[STAT_RFP] << " ("
+                  << pct(counters[STAT_RFP], nodes) << "% of main nodes)\n";
+        std::cout << "null move pruning     " << counters[STAT_NMP_TRIES] << " tries, "
+                  << pct(counters[STAT_NMP_CUTOFFS], counters[STAT_NMP_TRIES]) << "% cut\n";
+        std::cout << "late move pruning     " << counters[STAT_LMP] << " moves\n";
+        std::cout << "late move reductions  " << counters[STAT_LMR_SEARCHES] << " searches, "
+                  << pct(counters[STAT_LMR_RESEARCHES], counters[STAT_LMR_SEARCHES])
+                  << "% re-searched\n";
+        std::cout << "beta cutoffs          " << counters[STAT_BETA_CUTOFFS] << ", "
+                  << pct(counters[STAT_FIRST_MOVE_CUTOFFS], counters[STAT_BETA_CUTOFFS])
+                  << "% on the first move" << std::endl;
+        std::cout << std::defaultfloat << std::setprecision(6);
+    }
+};
+
+using SearchStats = SearchStatsT<SEARCH_STATS != 0>;
@@ -18,6 +18,10 @@ constexpr int VALUE_INF          = VALUE_MATE + 1;        // Infinity
 constexpr int VALUE_NONE         = VALUE_MATE + 2;        // No value
 constexpr int VALUE_MATE_IN_PLY  = VALUE_MATE - MAX_PLY;  // Mate distance bonus
 constexpr int VALUE_MATED_IN_PLY = -VALUE_MATE_IN_PLY;    // Mated distance penalty
+constexpr int VALUE_KNOWN_WIN    = 10000;                 // Won endgame, far from any mate
+
+// Lazy SMP
+constexpr int MAX_THREADS = 256;  // Maximum number of search threads
 
 // Transposition table
 constexpr int DEPTH_QS = 0;  // Depth value for quiescence search entries in TT
@@ -74,7 +78,7 @@ struct Limits {
     Time     time;
     uint64_t nodes      = 0;
     int      depth      = MAX_PLY;
-    bool     isInfinite = false;  // not handled yet
+    bool     isInfinite = false;  // search until stopped
 };
 
 /**
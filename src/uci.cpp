@@ -1,10 +1,19 @@
 #include "uci.h"
+#include "bench.h"
+#include "nnue.h"
+#include <charconv>
 
 void UCIEngine::print_engine_info() {
     std::cout << "id name CHIMP\n";
     std::cout << "id author Florian\n";
-    std::cout << "option name Hash type spin default 64 min 64 max 64\n";
-    std::cout << "option name Threads type spin default 1 min 1 max 1\n";
+    std::cout << "option name Hash type spin default " << TranspositionTable::DEFAULT_HASH_MiB
+              << " min " << TranspositionTable::MINHASH_MiB << " max "
+              << TranspositionTable::MAXHASH_MiB << "\n";
+    std::cout << "option name Clear Hash type button\n";
+    std::cout << "option name Threads type spin default 1 min 1 max " << MAX_THREADS << "\n";
+    std::cout << "option name EvalFile type string default <empty>\n";
+    std::cout << "option name BookFile type string default <empty>\n";
+    std::cout << "option name BookBestMove type check default false\n";
     std::cout << "uciok\n";
 }
 
@@ -47,10 +56,23 @@ void UCIEngine::go(std::istringstream& iss) {
     // Parse search parameters
     while (iss >> token)
     {
+        // go perft <depth> [threads <n>] [hash <MiB>]
         if (token == "perft")
         {
-            iss >> token;
-            start_perft(engine.board.getFen(), std::stoi(token));
+            int    perft_depth = 1, threads = 1;
+            size_t hash_mib    = 0;
+
+            iss >> perft_depth;
+            while (iss >> token)
+            {
+                if (token == "threads")
+                    iss >> threads;
+                else if (token == "hash")
+                    iss >> hash_mib;
+            }
+
+            start_perft(engine.board.getFen(), perft_depth,
+                        std::clamp(threads, 1, MAX_THREADS), hash_mib);
             return;
         }
         if (token == "depth")
@@ -92,12 +114,151 @@ void UCIEngine::go(std::istringstream& iss) {
     if (mate > 0)
         depth = mate * 2;
 
-    auto bestmove = engine.get_bestmove(depth);
-    std::cout << "bestmove " << uci::moveToUci(bestmove) << std::endl;
+    // play from the opening book without searching, unless the position is analysed
+    if (book.is_open() && !engine.limits.isInfinite && mate == 0)
+    {
+        Move bookmove = book.probe(engine.board, book_best_move);
+        if (bookmove != Move::NO_MOVE)
+        {
+            std::cout << "info string book move" << std::endl;
+            std::cout << "bestmove " << uci::moveToUci(bookmove) << std::endl;
+            return;
+        }
+    }
+
+    // cleared here rather than by the search thread, so that a stop sent right after
+    // go cannot be overwritten before the search has started
+    engine.stop_search = false;
+    searching          = true;
+
+    search_thread = std::thread([this, depth]() {
+        auto bestmove = engine.get_bestmove(depth);
+
+        // cleared first, so that a command answering the bestmove is never ignored
+        searching = false;
+        std::cout << "bestmove " << uci::moveToUci(bestmove) << std::endl;
+    });
+}
+
+void UCIEngine::stop() {
+    engine.stop_search = true;
+    wait_for_search();
+}
+
+void UCIEngine::wait_for_search() {
+    if (search_thread.joinable())
+        search_thread.join();
+}
+
+
+/**
+ * @brief Parses an option value holding a single integer
+ * @param value Option value
+ * @param result Set to the parsed integer on success
+ * @return True if the value is an integer and nothing else
+ */
+static bool parse_integer(const std::string& value, int64_t& result) {
+    const char* end = value.data() + value.size();
+    auto [ptr, ec]  = std::from_chars(value.data(), end, result);
+    return ec == std::errc() && ptr == end && !value.empty();
+}
+
+void UCIEngine::setoption(std::istringstream& is) {
+    std::string token, name, value;
+
+    // setoption name <id> [value <x>], where <id> may contain spaces
+    is >> token;
+    while (is >> token && token != "value")
+        name += (name.empty() ? "" : " ") + token;
+
+    while (is >> token)
+        value += (value.empty() ? "" : " ") + token;
+
+    int64_t number;
+
+    if (name == "Threads")
+    {
+        if (!parse_integer(value, number) || number < 1 || number > MAX_THREADS)
+        {
+            std::cout << "info string invalid Threads value " << value << std::endl;
+            return;
+        }
+
+        engine.set_threads(int(number));
+
+        // reallocate the table, so that its pages get spread over the NUMA nodes,
+        // unless it holds entries restored by loadhash that would be lost
+        if (engine.tt->is_loaded())
+            return;
+
+        engine.tt->resize(engine.tt->get_size_mib(), engine.get_num_threads());
+        print_hash_info();
+    }
+
+    else if (name == "Hash")
+    {
+        // signed parse, so that a negative size cannot wrap around to a huge one
+        if (!parse_integer(value, number) || number < int64_t(TranspositionTable::MINHASH_MiB)
+            || number > int64_t(TranspositionTable::MAXHASH_MiB))
+        {
+            std::cout << "info string invalid Hash value " << value << std::endl;
+            return;
+        }
+
+        if (engine.tt->is_loaded())
+            std::cout << "info string hash table loaded by loadhash discarded" << std::endl;
+
+        engine.tt->resize(uint64_t(number), engine.get_num_threads());
+        print_hash_info();
+    }
+
+    else if (name == "Clear Hash")
+    {
+        if (engine.tt->is_loaded())
+            std::cout << "info string hash table loaded by loadhash discarded" << std::endl;
+
+        engine.tt->clear(
+          std::max<int>(engine.get_num_threads(), std::thread::hardware_concurrency()));
+    }
+
+    else if (name == "EvalFile")
+    {
+        if (value.empty() || value == "<empty>")
+        {
+            nnue::unload();
+            std::cout << "info string classical evaluation enabled" << std::endl;
+        }
+        else if (nnue::load(value))
+            std::cout << "info string NNUE evaluation using " << value << " ("
+                      << nnue::simd_name() << ")" << std::endl;
+        else
+            std::cout << "info string failed to load " << value
+                      << ", missing file, different architecture or output weights out of range"
+                      << ", keeping "
+                      << (nnue::is_loaded() ? "previous network" : "classical evaluation")
+                      << std::endl;
+
+        // rebuild the accumulators of the current position with the new network
+        engine.board.refresh();
+        engine.clear_eval_caches();
+    }
+
+    else if (name == "BookFile")
+    {
+        if (value.empty() || value == "<empty>")
+            book.close();
+        else if (book.open(value))
+            std::cout << "info string opening book " << value << std::endl;
+        else
+            std::cout << "info string failed to open book " << value << std::endl;
+    }
+
+    else if (name == "BookBestMove")
+        book_best_move = value == "true";
 }
 
 
-void UCIEngine::eval() { std::cout << evaluate(engine.board) << std::endl; }
+void UCIEngine::eval() { std::cout << evaluate(engine.board, engine.eval_tables) << std::endl; }
 
 void UCIEngine::debug(std::istringstream& is){
     std::string token;
@@ -109,20 +270,93 @@ void UCIEngine::debug(std::istringstream& is){
         engine.debug = false;
 } 
 
+void UCIEngine::print_stats() {
+    std::cout << "info string eval cache hit rate " << engine.eval_cache.hit_rate()
+              << "%, pawn table hit rate " << engine.eval_tables.pawns.hit_rate() << "%"
+              << std::endl;
+
+    engine.get_search_stats().print();
+}
+
+void UCIEngine::print_hash_info() {
+    std::cout << "info string hash " << engine.tt->get_size_mib() << " MiB, "
+              << engine.tt->get_alloc_mode() << std::endl;
+}
+
+void UCIEngine::save_or_load_hash(std::istringstream& is, bool save) {
+    std::string path, token;
+
+    // the path may contain spaces
+    while (is >> token)
+        path += (path.empty() ? "" : " ") + token;
+
+    if (path.empty())
+        std::cout << "info string missing file path" << std::endl;
+
+    else if (save)
+        std::cout << "info string "
+                  << (engine.tt->save(path) ? "hash saved to " : "failed to save hash to ")
+                  << path << std::endl;
+
+    else if (engine.tt->load(path))
+        print_hash_info();
+
+    else
+        std::cout << "info string failed to load hash from " << path
+                  << ", missing file or different entry layout" << std::endl;
+}
+
 void UCIEngine::loop() {
     std::string token, input;
+    print_hash_info();
+
     do
     {
-        std::getline(std::cin, input);
+        // treat end of input as quit, so that piped sessions terminate
+        if (!std::getline(std::cin, input))
+            input = "quit";
+
         std::istringstream is(input);
         token.clear();
         is >> std::skipws >> token;
 
-        if (input == "uci")
-            print_engine_info();
+        // isready and stop are the only commands answered while searching
+        if (token == "isready")
+        {
+            std::cout << "readyok" << std::endl;
+            continue;
+        }
+
+        if (token == "stop" || token == "quit")
+        {
+            stop();
+            continue;
+        }
+
+        // WHILE SEARCHING
+        // a new search or position has to wait for the bestmove, which an infinite search
+        // would never send, so it is stopped instead. The other commands change the engine
+        // state the search is using, and are ignored.
+        if (searching)
+        {
+            if (token == "go" || token == "position" || token == "ucinewgame")
+            {
+                if (engine.limits.isInfinite)
+                    stop();
+            }
+            else
+            {
+                if (!token.empty())
+                    std::cout << "info string " << token << " ignored while searching"
+                              << std::endl;
+                continue;
+            }
+        }
+
+        wait_for_search();
 
-        else if (input == "isready")
-            std::cout << "readyok\n";
+        if (token == "uci")
+            print_engine_info();
 
         else if (token == "ucinewgame")
             engine.reset();
@@ -133,11 +367,26 @@ void UCIEngine::loop() {
         else if (token == "go")
             go(is);
 
+        else if (token == "setoption")
+            setoption(is);
+
         else if (token == "eval")
             eval();
 
+        else if (token == "bench")
+            bench::command(is);
+
+        else if (token == "savehash")
+            save_or_load_hash(is, true);
+
+        else if (token == "loadhash")
+            save_or_load_hash(is, false);
+
         else if (token == "debug")
             debug(is);
 
-    } while (token != "quit" && token != "stop");
+        else if (token == "stats")
+            print_stats();
+
+    } while (token != "quit");
 }
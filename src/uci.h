@@ -1,4 +1,5 @@
 #pragma once
+#include "book.h"
 #include "chess.hpp"
 #include "engine.h"
 #include "evaluate.h"
@@ -6,6 +7,8 @@
 #include "types.h"
 #include "time.h"
 #include <algorithm>
+#include <atomic>
+#include <thread>
 
 using namespace chess;
 
@@ -34,10 +37,32 @@ class UCIEngine {
 
     /**
      * @brief Processes the UCI 'go' command
+     *
+     * The search runs on a dedicated thread, so that the command loop keeps
+     * answering 'isready' and 'stop' while the engine is thinking.
+     *
      * @param is Input stream containing search parameters
      */
     void go(std::istringstream& is);
 
+    /**
+     * @brief Processes the UCI 'stop' command
+     *
+     * Raises the stop flag of the running search and waits for it to print its bestmove.
+     */
+    void stop();
+
+    /**
+     * @brief Blocks until the running search, if any, has finished
+     */
+    void wait_for_search();
+
+    /**
+     * @brief Processes the UCI 'setoption' command
+     * @param is Input stream containing the option name and value
+     */
+    void setoption(std::istringstream& is);
+
     /**
      * @brief Outputs the static evaluation of the current position
      */
@@ -60,5 +85,41 @@ class UCIEngine {
      */
     void debug(std::istringstream& is);
 
+    /**
+     * @brief Handles the non-standard 'stats' command
+     * 
+     * Outputs the hit rates of the evaluation caches and the search statistics
+     * of the last search.
+     */
+    void print_stats();
+
+    /**
+     * @brief Outputs the size and memory allocation mode of the hash table
+     */
+    void print_hash_info();
+
+    /**
+     * @brief Handles the non-standard 'savehash <file>' and 'loadhash <file>' commands
+     * 
+     * Saves the transposition table to a file, or reloads a table saved earlier so
+     * that a deep analysis can resume with a warm table.
+     * 
+     * @param is Input stream containing the file path
+     * @param save True to save the table, false to load it
+     */
+    void save_or_load_hash(std::istringstream& is, bool save);
+
     Engine engine;
+
+    // Opening book, probed before searching
+    PolyglotBook book;
+
+    // Plays the highest weighted book move instead of a weighted random one
+    bool book_best_move = false;
+
+    // Thread running the current search
+    std::thread search_thread;
+
+    // Set from go until the search thread has printed its bestmove
+    std::atomic<bool> searching = false;
 };
\ No newline at end of file